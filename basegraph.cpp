@@ -25,6 +25,113 @@ struct radarline {
   color_t line;
   };
 
+/** A map from cells to their on-screen coordinates. Mostly compatible with map<cell*, shiftmatrix_or_null>,
+ *  but is cleared every frame, so clear() just bumps the generation stamp of the hash index, and the lookups
+ *  are hash lookups rather than tree walks. The entries are kept in insertion order, in chunks, so that
+ *  the references stay valid while new cells are added.
+ */
+struct cellmatrix_map {
+  using key_type = cell*;
+  using mapped_type = shiftmatrix_or_null;
+  using value_type = pair<cell*, shiftmatrix_or_null>;
+
+  private:
+  static constexpr int CHUNK_BITS = 10;
+  static constexpr int CHUNK = 1 << CHUNK_BITS;
+  struct slot { cell *c; unsigned stamp; int id; };
+  vector<unique_ptr<value_type[]>> chunks;
+  vector<slot> index;
+  unsigned stamp = 1;
+  int qty = 0;
+
+  value_type& entry(int id) const { return chunks[id >> CHUNK_BITS][id & (CHUNK-1)]; }
+
+  /** the position in index where c is, or should be inserted */
+  int find_pos(cell *c) const {
+    int mask = isize(index) - 1;
+    for(int h = (reinterpret_cast<size_t>(c) * 0x9E3779B97F4A7C15ull) >> 32 & mask;; h = (h + 1) & mask) {
+      auto& s = index[h];
+      if(s.stamp != stamp || s.c == c) return h;
+      }
+    }
+
+  void rebuild_index(int size) {
+    index.clear(); index.resize(size, slot{nullptr, 0, 0});
+    for(int id=0; id<qty; id++) {
+      auto& s = index[find_pos(entry(id).first)];
+      s.c = entry(id).first; s.stamp = stamp; s.id = id;
+      }
+    }
+
+  int find_id(cell *c) const {
+    if(!qty) return -1;
+    auto& s = index[find_pos(c)];
+    return s.stamp == stamp ? s.id : -1;
+    }
+
+  public:
+  template<class M, class V> struct iterator_base {
+    M *m; int id;
+    V& operator * () const { return m->entry(id); }
+    V* operator -> () const { return &m->entry(id); }
+    iterator_base& operator ++ () { id++; return *this; }
+    bool operator == (const iterator_base& i) const { return id == i.id; }
+    bool operator != (const iterator_base& i) const { return id != i.id; }
+    };
+  using iterator = iterator_base<cellmatrix_map, value_type>;
+  using const_iterator = iterator_base<const cellmatrix_map, const value_type>;
+
+  iterator begin() { return iterator{this, 0}; }
+  iterator end() { return iterator{this, qty}; }
+  const_iterator begin() const { return const_iterator{this, 0}; }
+  const_iterator end() const { return const_iterator{this, qty}; }
+
+  size_t size() const { return qty; }
+  bool empty() const { return qty == 0; }
+  size_t count(cell *c) const { return find_id(c) != -1; }
+
+  iterator find(cell *c) { int id = find_id(c); return iterator{this, id == -1 ? qty : id}; }
+  const_iterator find(cell *c) const { int id = find_id(c); return const_iterator{this, id == -1 ? qty : id}; }
+
+  shiftmatrix_or_null& operator [] (cell *c) {
+    if(2 * (qty + 1) > isize(index)) rebuild_index(max(2 * isize(index), 2 * CHUNK));
+    auto& s = index[find_pos(c)];
+    if(s.stamp == stamp) return entry(s.id).second;
+    if((qty >> CHUNK_BITS) == isize(chunks)) chunks.emplace_back(new value_type[CHUNK]);
+    s.c = c; s.stamp = stamp; s.id = qty++;
+    auto& e = entry(s.id);
+    e.first = c; e.second = shiftmatrix_or_null();
+    return e.second;
+    }
+
+  shiftmatrix_or_null& at(cell *c) {
+    int id = find_id(c);
+    if(id == -1) throw std::out_of_range("cellmatrix_map::at");
+    return entry(id).second;
+    }
+
+  /** O(1) unless the stamp wraps around */
+  void clear() {
+    qty = 0;
+    if(!++stamp) { stamp = 1; for(auto& s: index) s.stamp = 0; }
+    }
+
+  friend void swap(cellmatrix_map& a, cellmatrix_map& b) {
+    std::swap(a.chunks, b.chunks); std::swap(a.index, b.index); std::swap(a.stamp, b.stamp); std::swap(a.qty, b.qty);
+    }
+
+  cellmatrix_map() {}
+  cellmatrix_map(cellmatrix_map&& m) { swap(self, m); }
+  cellmatrix_map& operator = (cellmatrix_map&& m) { swap(self, m); m.clear(); return self; }
+  cellmatrix_map(const cellmatrix_map& m) { self = m; }
+  cellmatrix_map& operator = (const cellmatrix_map& m) {
+    if(&m == this) return self;
+    clear();
+    for(auto& p: m) self[p.first] = p.second;
+    return self;
+    }
+  };
+
 /** configuration of the current view */
 struct display_data {
   /** The cell which is currently in the center. */
@@ -36,7 +143,7 @@ struct display_data {
   /** The view relative to the player character. */
   shiftmatrix player_matrix;
   /** On-screen coordinates for all the visible cells. */
-  map<cell*, shiftmatrix_or_null> cellmatrices, old_cellmatrices;
+  cellmatrix_map cellmatrices, old_cellmatrices;
   /** Position of the current map view, relative to the screen (0 to 1). */
   ld xmin, ymin, xmax, ymax;
   /** Position of the current map view, in pixels. */
@@ -493,6 +600,12 @@ struct glfont_t {
   GLuint texture;                                     // Holds The Texture Id
 //GLuint list_base;                                   // Holds The First Display List ID  
   vector<charinfo_t> chars; 
+  /** the glyphs are placed by init_glfont, but rasterised by require_glyph when first drawn */
+  vector<char> ready;
+  int theight;
+  #if CAP_SDLTTF
+  TTF_Font *font;
+  #endif
   };
 #endif
 
@@ -500,9 +613,34 @@ typedef Uint16 texturepixel;
 
 #define FONTTEXTURESIZE 4096
 
+/** rasterise all the glyphs at once: needed when they are read sequentially from the font table, or when the font table is being created */
+#define EAGER_GLYPHS (CAP_TABFONT || CAP_CREATEFONT)
+
 int curx = 0, cury = 0, theight = 0;
+
+#if EAGER_GLYPHS
 texturepixel fontpixels[FONTTEXTURESIZE][FONTTEXTURESIZE];
+#endif
+
+/** reserve the place for a glyph of size otwidth x otheight in the font texture */
+void place_glyph(glfont_t& f, int ch, int otwidth, int otheight) {
+  if(otwidth+curx+1 > FONTTEXTURESIZE) curx = 0, cury += theight+1, theight = 0;
+  
+  theight = max(theight, otheight);
+  
+  auto& c = f.chars[ch];
+  
+  c.w = otwidth;
+  c.h = otheight;
 
+  c.tx0 = (float) curx / (float) FONTTEXTURESIZE;
+  c.tx1 = (float) (curx+otwidth) / (float) FONTTEXTURESIZE;
+  c.ty0 = (float) cury;
+  c.ty1 = (float) (cury+otheight);
+  curx += otwidth+1;
+  }
+
+#if EAGER_GLYPHS
 void sdltogl(SDL_Surface *txt, glfont_t& f, int ch) {
 #if CAP_TABFONT
   if(ch < 32) return;
@@ -515,29 +653,61 @@ void sdltogl(SDL_Surface *txt, glfont_t& f, int ch) {
   int otheight = txt->h;
 #endif
   
-  if(otwidth+curx+1 > FONTTEXTURESIZE) curx = 0, cury += theight+1, theight = 0;
-  
-  theight = max(theight, otheight);
+  place_glyph(f, ch, otwidth, otheight);
+  int x0 = curx - otwidth - 1, y0 = cury;
   
   for(int j=0; j<otheight;j++) for(int i=0; i<otwidth; i++) {
-    fontpixels[j+cury][i+curx] =
+    fontpixels[j+y0][i+x0] =
 #if CAP_TABFONT
     (i>=otwidth || j>=otheight) ? 0 : (tpix[tpixindex++] * 0x100) | 0xFF;
 #else
     ((i>=txt->w || j>=txt->h) ? 0 : ((qpixel(txt, i, j)>>24)&0xFF) * 0x100) | 0x00FF;
 #endif
     }
-  
-  auto& c = f.chars[ch];
-  
-  c.w = otwidth;
-  c.h = otheight;
+  }
+#endif
 
-  c.tx0 = (float) curx / (float) FONTTEXTURESIZE;
-  c.tx1 = (float) (curx+otwidth) / (float) FONTTEXTURESIZE;
-  c.ty0 = (float) cury;
-  c.ty1 = (float) (cury+otheight);
-  curx += otwidth+1;
+#if !CAP_TABFONT
+SDL_Surface *render_glyph(TTF_Font *font, int ch) {
+  SDL_Color white;
+  white.r = white.g = white.b = 255;
+  if(ch < 128) {
+    char str[2]; str[0] = ch; str[1] = 0;
+    return TTF_RenderText_Blended(font, str, white);
+    }
+  else
+    return TTF_RenderUTF8_Blended(font, natchars[ch-128], white);
+  }
+#endif
+
+#if !EAGER_GLYPHS
+/** the size of the glyph, as it will be rendered by render_glyph */
+bool measure_glyph(TTF_Font *font, int ch, int& w, int& h) {
+  char str[2]; str[0] = ch; str[1] = 0;
+  return TTF_SizeUTF8(font, ch < 128 ? str : natchars[ch-128], &w, &h) == 0;
+  }
+#endif
+
+/** make sure that the glyph ch of f is rasterised in its texture */
+EX void require_glyph(glfont_t& f, int ch) {
+#if !EAGER_GLYPHS
+  if(f.ready[ch]) return;
+  f.ready[ch] = true;
+  auto& c = f.chars[ch];
+  if(!c.w || !c.h) return;
+  SDL_Surface *txt = render_glyph(f.font, ch);
+  if(!txt) return;
+  /* rows of 2-byte pixels, padded to the default unpack alignment of 4 */
+  int stride = (c.w + 1) & ~1;
+  vector<texturepixel> pix(stride * c.h, 0);
+  for(int j=0; j<c.h && j<txt->h; j++) for(int i=0; i<c.w && i<txt->w; i++)
+    pix[j*stride+i] = (((qpixel(txt, i, j)>>24)&0xFF) * 0x100) | 0x00FF;
+  SDL_FreeSurface(txt);
+  glBindTexture(GL_TEXTURE_2D, f.texture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, int(c.tx0 * FONTTEXTURESIZE + .5), int(c.ty0 * f.theight + .5), c.w, c.h,
+    GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, pix.data());
+  GLERR("require_glyph");
+#endif
   }
   
 EX void init_glfont(int size) {
@@ -554,25 +724,27 @@ EX void init_glfont(int size) {
   glfont_t& f(*(cfont->glfont[size]));
   
   f.chars.resize(CHARS);
+  f.ready.resize(CHARS, EAGER_GLYPHS);
 
 //f.list_base = glGenLists(128);
   glGenTextures(1, &f.texture );
 
-#if !CAP_TABFONT
-  char str[2]; str[1] = 0;
-  
-  SDL_Color white;
-  white.r = white.g = white.b = 255;
-#endif
-
+#if EAGER_GLYPHS
   for(int y=0; y<FONTTEXTURESIZE; y++)
   for(int x=0; x<FONTTEXTURESIZE; x++)
     fontpixels[y][x] = 0;
+#endif
 
 #if CAP_TABFONT
   resetTabFont();
 #endif
   
+#if !CAP_TABFONT
+  int siz = size;
+  fix_font_size(siz);
+  f.font = cfont->font[siz];
+#endif
+
 //  glListBase(0);
 
   curx = 0, cury = 0, theight = 0;
@@ -584,23 +756,18 @@ EX void init_glfont(int size) {
 #if CAP_TABFONT
     sdltogl(NULL, f, ch);
 
-#else
-    SDL_Surface *txt;
-    int siz = size;
-    fix_font_size(siz);
-    if(ch < 128) {
-      str[0] = ch;
-      txt = TTF_RenderText_Blended(cfont->font[siz], str, white);
-      }
-    else {
-      txt = TTF_RenderUTF8_Blended(cfont->font[siz], natchars[ch-128], white);
-      }
+#elif EAGER_GLYPHS
+    SDL_Surface *txt = render_glyph(f.font, ch);
     if(txt == NULL) continue;
 #if CAP_CREATEFONT
     generateFont(ch, txt);
 #endif
     sdltogl(txt, f, ch);
     SDL_FreeSurface(txt);    
+#else
+    int w, h;
+    if(!measure_glyph(f.font, ch, w, h)) continue;
+    place_glyph(f, ch, w, h);
 #endif
     }
 
@@ -609,10 +776,18 @@ EX void init_glfont(int size) {
   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
   
   theight = next_p2(cury + theight);
+  f.theight = theight;
   
+#if EAGER_GLYPHS
   glTexImage2D( GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, FONTTEXTURESIZE, theight, 0,
     GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, 
     fontpixels);
+#else
+  vector<texturepixel> empty(FONTTEXTURESIZE * theight, 0);
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, FONTTEXTURESIZE, theight, 0,
+    GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, 
+    empty.data());
+#endif
 
   for(int ch=0; ch<CHARS; ch++) f.chars[ch].ty0 /= theight, f.chars[ch].ty1 /= theight;
  
@@ -700,6 +875,7 @@ bool gl_print(int x, int y, int shift, int size, const char *s, color_t color, i
   for(int i=0; s[i];) {
   
     int tabid = getnext(s,i);
+    require_glyph(f, tabid);
     auto& c = f.chars[tabid];
     int wi = c.w * size/gsiz;
     int hi = c.h * size/gsiz;
@@ -832,6 +1008,48 @@ EX bool displaystr(int x, int y, int shift, int size, char const *s, color_t col
 
 #endif
 #if !CAP_XGD
+#if CAP_SDLTTF
+/** how many rendered strings to keep for the non-GL displaystr (at least one is kept) */
+EX int text_surface_cache_size = 256;
+
+struct text_surface {
+  SDL_Surface *txt;
+  int last_used;
+  };
+
+/** rendered strings, by font, size, antialiasing, color, and the string */
+map<tuple<fontdata*, int, bool, color_t, string>, text_surface> text_surfaces;
+int text_surface_clock;
+
+EX void clear_text_surfaces() {
+  for(auto& ts: text_surfaces) SDL_FreeSurface(ts.second.txt);
+  text_surfaces.clear();
+  }
+
+/** render str in the given size and color, or find it among the recently rendered ones; the result should not be freed */
+SDL_Surface *render_text(int size, const char *str, SDL_Color col) {
+  bool blended = vid.antialias & AA_FONT;
+  auto key = make_tuple(cfont, size, blended, color_t((col.r << 16) | (col.g << 8) | col.b), string(str));
+  auto it = text_surfaces.find(key);
+  if(it != text_surfaces.end()) {
+    it->second.last_used = ++text_surface_clock;
+    return it->second.txt;
+    }
+  SDL_Surface *txt = (blended?TTF_RenderUTF8_Blended:TTF_RenderUTF8_Solid)(cfont->font[size], str, col);
+  if(txt == NULL) return NULL;
+  /* forget the least recently used one */
+  if(isize(text_surfaces) >= max(text_surface_cache_size, 1)) {
+    auto oldest = text_surfaces.begin();
+    for(auto it = text_surfaces.begin(); it != text_surfaces.end(); it++)
+      if(it->second.last_used < oldest->second.last_used) oldest = it;
+    SDL_FreeSurface(oldest->second.txt);
+    text_surfaces.erase(oldest);
+    }
+  text_surfaces[key] = text_surface{txt, ++text_surface_clock};
+  return txt;
+  }
+#endif
+
 EX bool displaystr(int x, int y, int shift, int size, const char *str, color_t color, int align) {
 
   if(strlen(str) == 0) return false;
@@ -860,7 +1078,7 @@ EX bool displaystr(int x, int y, int shift, int size, const char *str, color_t c
   fix_font_size(size);
   loadfont(size);
 
-  SDL_Surface *txt = ((vid.antialias & AA_FONT)?TTF_RenderUTF8_Blended:TTF_RenderUTF8_Solid)(cfont->font[size], str, col);
+  SDL_Surface *txt = render_text(size, str, col);
   
   if(txt == NULL) return false;
 
@@ -894,7 +1112,6 @@ EX bool displaystr(int x, int y, int shift, int size, const char *str, color_t c
   else {
     SDL_BlitSurface(txt, NULL, s,&rect); 
     }
-  SDL_FreeSurface(txt);
   
   return clicked;
 #endif
@@ -1492,6 +1709,9 @@ EX void init_font() {
   }
 
 fontdata::~fontdata() {
+#if CAP_SDLTTF && !CAP_XGD
+  clear_text_surfaces();
+#endif
 #if CAP_SDLTTF
   for(int i=0; i<=max_font_size; i++) if(font[i]) {
     TTF_CloseFont(font[i]);
@@ -89,7 +89,19 @@ public:
  *  Liskov substitution warning: maps which produce both tiling like above and 3D tilings
  *  (e.g. Euclidean and Crystal) also inherit from hrmap_standard
  **/
+/** a jump pointer in the tree of heptagons formed by move(0), see hrmap_standard::get_jump */
+struct heptagon_jump {
+  /** an ancestor of the heptagon, or NULL if the tree ends before reaching the required depth */
+  heptagon *target;
+  /** the position of target relative to the heptagon */
+  transmatrix T;
+  };
+
 struct hrmap_standard : hrmap {
+  /** jump pointers memoised by get_jump; heptagons of these maps are deleted only together with the map */
+  std::unordered_map<heptagon*, heptagon_jump> jumps;
+  const heptagon_jump& get_jump(heptagon *h);
+  transmatrix relative_matrix_jumps(heptagon *h2, heptagon *h1, transmatrix gm, transmatrix where);
   void draw_at(cell *at, const shiftmatrix& where) override;
   transmatrix relative_matrixh(heptagon *h2, heptagon *h1, const hyperpoint& hint) override;
   transmatrix relative_matrixc(cell *c2, cell *c1, const hyperpoint& hint) override;
@@ -125,8 +137,7 @@ struct hrmap_hyperbolic : hrmap_standard {
 #endif
 
 void hrmap_standard::on_dim_change() {
-  for(auto& p: gp::gp_swapped) swapmatrix(gp::gp_adj[p]);
-  gp::gp_swapped.clear();
+  gp::unswap_adj();
   }
 
 double hrmap::spacedist(cell *c, int i) { return hdist(tile_center(), adj(c, i) * tile_center()); }
@@ -290,6 +301,7 @@ void hrmap_standard::find_cell_connection(cell *c, int d) {
   #if CAP_GP
   else if(GOLDBERG) {
     gp::extend_map(c, d);
+    if(gp::do_adjm) gp::compact_adj();
     if(!c->move(d)) {
       println(hlog, "extend failed to create for ", cellwalker(c, d));
       exit(1);
@@ -1387,7 +1399,143 @@ EX cell *random_in_distance(cell *c, int d) {
   return choices[hrand(isize(choices))];
   }
 
+/** closed manifolds with at most this many cells get a precomputed all-pairs distance table (0 = never) */
+EX int distance_table_limit = 8192;
+
+/** if not empty, the all-pairs distance tables are cached in this directory */
+EX string distance_table_dir;
+
+/** \brief all-pairs distances on a closed manifold, stored as a cell-indexed matrix
+ *
+ *  Computed once by a BFS from every cell, in parallel (see engine_threads). Entries are 8-bit if the
+ *  diameter allows, and 16-bit otherwise; unreachable pairs store the largest value.
+ */
+struct distance_table {
+  /** 0 = not computed yet, 1 = available, -1 = not available for this map */
+  int state;
+  /** the map for which this table has been computed */
+  hrmap *owner;
+  int n;
+  bool wide;
+  unsigned long long signature;
+  std::unordered_map<cell*, int> index;
+  vector<unsigned char> d8;
+  vector<unsigned short> d16;
+
+  distance_table() { clear(); }
+
+  void clear() {
+    state = 0; owner = nullptr; n = 0; wide = false; signature = 0;
+    index.clear(); d8.clear(); d16.clear();
+    }
+
+  int get(int i, int j) {
+    long long at = (long long) i * n + j;
+    if(wide) return d16[at] == 0xFFFF ? DISTANCE_UNKNOWN : d16[at];
+    return d8[at] == 0xFF ? DISTANCE_UNKNOWN : d8[at];
+    }
+
+  template<class T> void fill(vector<T>& d, const vector<int>& adj, const vector<int>& adjstart) {
+    d.resize((long long) n * n);
+    run_parallel(n, [&] (int a, int b) {
+      vector<int> queue(n);
+      for(int src=a; src<b; src++) {
+        T *row = &d[(long long) src * n];
+        for(int i=0; i<n; i++) row[i] = T(-1);
+        row[src] = 0;
+        int qb = 0, qe = 0;
+        queue[qe++] = src;
+        while(qb < qe) {
+          int i = queue[qb++];
+          for(int k=adjstart[i]; k<adjstart[i+1]; k++) {
+            int j = adj[k];
+            if(row[j] == T(-1) && row[i] + 1 < T(-1)) row[j] = row[i] + 1, queue[qe++] = j;
+            }
+          }
+        }
+      return 0;
+      });
+    }
+
+  string cache_name() { return distance_table_dir + "/distances-" + itsh(signature) + ".dat"; }
+
+  bool load() {
+    if(distance_table_dir == "" || !file_exists(cache_name())) return false;
+    try {
+      fhstream f(cache_name(), "rb");
+      if(!f.f) return false;
+      if(f.get<unsigned long long>() != signature || f.get<int>() != n || f.get<char>() != wide) return false;
+      if(wide) { d16.resize((long long) n * n); f.read_chars((char*) &d16[0], d16.size() * 2); }
+      else { d8.resize((long long) n * n); f.read_chars((char*) &d8[0], d8.size()); }
+      return true;
+      }
+    catch(hstream_exception&) {
+      d8.clear(); d16.clear();
+      return false;
+      }
+    }
+
+  void save() {
+    if(distance_table_dir == "") return;
+    try {
+      fhstream f(cache_name(), "wb");
+      if(!f.f) return;
+      f.write(signature); f.write(n); f.write<char>(wide);
+      if(wide) f.write_chars((char*) &d16[0], d16.size() * 2);
+      else f.write_chars((char*) &d8[0], d8.size());
+      }
+    catch(hstream_exception&) {}
+    }
+
+  void compute() {
+    clear();
+    state = -1;
+    owner = currentmap;
+    if(!distance_table_limit) return;
+    celllister cl(currentmap->gamestart(), 1000000, distance_table_limit+1, NULL);
+    n = isize(cl.lst);
+    if(n > distance_table_limit) return;
+
+    for(int i=0; i<n; i++) index[cl.lst[i]] = i;
+    vector<int> adj, adjstart;
+    for(int i=0; i<n; i++) {
+      adjstart.push_back(isize(adj));
+      forCellCM(c2, cl.lst[i]) {
+        if(!index.count(c2)) { index.clear(); return; }
+        adj.push_back(index[c2]);
+        }
+      }
+    adjstart.push_back(isize(adj));
+
+    /* the quotient signature: the adjacency structure, in the celllister order */
+    signature = n;
+    for(int i: adjstart) signature = signature * 0x100000001B3ull + i;
+    for(int j: adj) signature = signature * 0x100000001B3ull + j;
+
+    /* the diameter is at most twice the eccentricity of any cell */
+    int ecc = 0;
+    for(int d: cl.dists) ecc = max(ecc, d);
+    wide = 2 * ecc >= 0xFF;
+
+    if(!load()) {
+      if(wide) fill(d16, adj, adjstart);
+      else fill(d8, adj, adjstart);
+      save();
+      }
+    state = 1;
+    }
+  };
+
+distance_table manifold_distances;
+
 EX int bounded_celldistance(cell *c1, cell *c2) {
+  if(manifold_distances.state == 0 || manifold_distances.owner != currentmap) manifold_distances.compute();
+  if(manifold_distances.state == 1) {
+    auto& md = manifold_distances;
+    auto i1 = md.index.find(c1), i2 = md.index.find(c2);
+    if(i1 != md.index.end() && i2 != md.index.end()) return md.get(i1->second, i2->second);
+    }
+
   int limit = 14400;
   #if CAP_SOLV
   if(geometry == gArnoldCat) { 
@@ -1550,9 +1698,10 @@ EX void clearCellMemory() {
   last_cleared = NULL;
   saved_distances.clear();
   dists_computed.clear();
+  manifold_distances.clear();
   keep_distances_from.clear(); perma_distances = 0;
   pd_from = NULL;
-  gp::gp_adj.clear();
+  gp::clear_adj();
   }
 
 auto cellhooks = addHook(hooks_clearmemory, 500, clearCellMemory);
@@ -170,6 +170,9 @@ int arg::readCommon() {
   else if(argis("-no-s")) { PHASE(2); scorefile = ""; savefile_selection = false; }
   else if(argis("-rsrc")) { PHASE(1); shift(); rsrcdir = args(); }
   else if(argis("-nogui")) { PHASE(1); noGUI = true; }
+  else if(argis("-ethreads")) { shift(); engine_threads = max(argi(), 1); }
+  else if(argis("-dtable-limit")) { shift(); distance_table_limit = argi(); }
+  else if(argis("-dtable-dir")) { shift(); distance_table_dir = args(); }
 #ifndef EMSCRIPTEN
 #if CAP_SDL
   else if(argis("-font")) { PHASE(1); shift(); font_id = isize(font_filenames); font_filenames.push_back(args()); font_names.push_back({args(), "commandline"}); }
@@ -1099,6 +1099,10 @@ EX void initConfig() {
   -> set_reaction(compute_fsize)
   -> set_sets([] { dialog::bound_low(0); });
 
+  #if CAP_SDLTTF && !CAP_XGD
+  param_i(text_surface_cache_size, "text_surface_cache", 256);
+  #endif
+
   param_i(vid.mobilecompasssize, "mobile compass size", 0); // ISMOBILE || ISPANDORA ? 30 : 0);
   param_i(vid.radarsize, "radarsize size", 120);
   param_f(vid.radarrange, "radarrange", 2.5);
@@ -1345,6 +1349,7 @@ EX void initConfig() {
   
   param_b(memory_saving_mode, "memory_saving_mode", (ISMOBILE || ISPANDORA || ISWEB) ? 1 : 0);
   param_i(reserve_limit, "memory_reserve", 128);
+  param_i(cgi_cache_size, "cgi_cache_size", 3);
   param_b(show_memory_warning, "show_memory_warning");
 
   param_b(rug::renderonce, "rug-renderonce");
@@ -1381,6 +1386,10 @@ EX void initConfig() {
   ->set_extra(draw_crosshair);
   
   param_b(mapeditor::drawplayer, "drawplayer");
+  #if CAP_EDIT
+  param_b(mapstream::save_chunked, "save_chunked");
+  param_i(mapstream::chunk_size, "map_chunk_size", 65536);
+  #endif
 
   param_color(backcolor, "color:background", false);
   param_color(forecolor, "color:foreground", false);
@@ -4197,6 +4206,9 @@ EX int read_config_args() {
   else if(argis("-mrsv")) {
     PHASEFROM(2); shift(); reserve_limit = argi(); apply_memory_reserve();
     }
+  else if(argis("-cgi-cache")) {
+    PHASEFROM(2); shift(); cgi_cache_size = max(argi(), 0);
+    }
   else if(argis("-pside")) {
     PHASEFROM(2); 
     permaside = true;
@@ -767,6 +767,19 @@ int read_cheat_args() {
     for(int i=0; i<isize(cl.lst); i++)
       setdist(cl.lst[i], 7, NULL);
     }
+  else if(argis("-gencells-bulk")) {
+    PHASEFROM(2); shift(); start_game();
+    celllister cl(cwt.at, 50, argi(), NULL);
+    setdist_bulk(cl.lst, 7);
+    printf("Cells generated: %d\n", isize(cl.lst));
+    }
+  else if(argis("-landgen-profile")) {
+    landgen_profiling = true;
+    landgen_profile.clear();
+    }
+  else if(argis("-landgen-report")) {
+    shift(); print_landgen_profile(argi());
+    }
   else if(argis("-sr")) {    
     PHASEFROM(2);
     shift(); sightrange_bonus = argi(); vid.use_smart_range = 0;
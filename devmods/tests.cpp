@@ -104,6 +104,232 @@ int readArgs() {
     if(errors) exit(1);
     }
 
+  else if(argis("-bench-gp-adj")) {
+    /* GP adjacency matrices are stored only in quotient and spherical geometries, e.g. -bench-gp-adj 100000 on a field quotient with -gp 2 1 */
+    start_game();
+    shift(); int n = argi();
+    vector<cell*> l = { currentmap->gamestart() };
+    set<cell*> seen = { l[0] };
+    for(int k=0; k<isize(l) && isize(l) < n; k++)
+      for(int i=0; i<l[k]->type; i++) {
+        cell *c1 = l[k]->cmove(i);
+        if(!seen.count(c1)) seen.insert(c1), l.push_back(c1);
+        }
+    ld lookups = 0;
+    int start = SDL_GetTicks();
+    for(int it=0; it<10; it++)
+      for(cell *c: l) for(int i=0; i<c->type; i++) {
+        transmatrix T = currentmap->adj(c, i) * currentmap->adj(c->move(i), c->c.spin(i));
+        lookups += 2;
+        if(it == 0 && !eqmatrix(T, Id)) errors++;
+        }
+    int t = SDL_GetTicks() - start;
+    int pages = 0, rss = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if(f) { if(fscanf(f, "%d%d", &pages, &rss) != 2) rss = 0; fclose(f); }
+    println(hlog, "cells: ", isize(l), " lookups/s: ", t ? lookups * 1000 / t : lookups, " RSS: ", rss * 4, " kB",
+      " table: ", gp::gp_adj_table_used, " exceptions: ", isize(gp::gp_adj), " errors: ", errors, " in: ", full_geometry_name());
+    if(errors) exit(1);
+    }
+
+  else if(argis("-bench-cgi")) {
+    /* visit a list of geometries twice, to see the effect of cgi_cache_size on the switching time */
+    PHASEFROM(3);
+    vector<eGeometry> geos = {gNormal, gEuclid, gSphere, gOctagon, g45, gEuclidSquare, gKleinQuartic, gBolza};
+    for(int round=0; round<2; round++) {
+      int total = 0;
+      for(eGeometry g: geos) {
+        int start = SDL_GetTicks();
+        stop_game();
+        set_geometry(g);
+        start_game();
+        check_cgi();
+        cgi.require_shapes();
+        total += SDL_GetTicks() - start;
+        }
+      println(hlog, "round ", round, ": ", total, " ms for ", isize(geos), " geometries, cached: ", isize(cgis));
+      }
+    }
+
+  else if(argis("-bench-mapsave")) {
+    /* round trip of a map of N cells through a file and through a string */
+    start_game();
+    shift(); int n = argi();
+    vector<cell*> l = { cwt.at };
+    set<cell*> seen = { cwt.at };
+    for(int k=0; k<isize(l) && isize(l) < n; k++)
+      for(int i=0; i<l[k]->type; i++) {
+        cell *c1 = l[k]->cmove(i);
+        if(!seen.count(c1)) seen.insert(c1), l.push_back(c1);
+        }
+    /* cells without land are not saved */
+    for(cell *c: l) if(c->land == laNone) c->land = laCanvas;
+    string fname = "bench-mapsave.lev";
+    int t0 = SDL_GetTicks();
+    mapstream::saveMap(fname.c_str());
+    int t1 = SDL_GetTicks();
+    mapstream::loadMap(fname);
+    int t2 = SDL_GetTicks();
+    shstream ss;
+    mapstream::saveMap(ss);
+    int t3 = SDL_GetTicks();
+    mapstream::loadMap(ss);
+    int t4 = SDL_GetTicks();
+    remove(fname.c_str());
+    println(hlog, "cells: ", isize(l), " bytes: ", isize(ss.s), " file save: ", t1-t0, " ms load: ", t2-t1, " ms; string save: ", t3-t2, " ms load: ", t4-t3, " ms");
+    /* the chunked format should load to the same map; the cell orientations may differ between loads, so compare the sorted contents */
+    auto contents = [] {
+      vector<array<int, 6>> res;
+      for(cell *c: currentmap->allcells()) if(c->land != laNone)
+        res.push_back({c->land, c->wall, c->monst, c->item, c->wparam, c->landparam});
+      sort(res.begin(), res.end());
+      return res;
+      };
+    auto orig = contents();
+    shstream sc;
+    dynamicval<bool> dc(mapstream::save_chunked, true);
+    int t5 = SDL_GetTicks();
+    mapstream::saveMap(sc);
+    int t6 = SDL_GetTicks();
+    mapstream::loadMap(sc);
+    int t7 = SDL_GetTicks();
+    if(contents() != orig) errors++;
+    println(hlog, "chunked bytes: ", isize(sc.s), " save: ", t6-t5, " ms load: ", t7-t6, " ms threads: ", engine_threads, " errors: ", errors);
+    if(errors) exit(1);
+    }
+
+  else if(argis("-bench-pregen")) {
+    /* pregenerate the map to radius R and load it back; the loaded map should contain the same cells */
+    start_game();
+    shift(); int radius = argi();
+    string fname = "bench-pregen.lev";
+    int t0 = SDL_GetTicks();
+    if(!mapstream::save_pregenerated(fname, radius)) errors++;
+    int t1 = SDL_GetTicks();
+    auto contents = [radius] {
+      vector<array<int, 6>> res;
+      celllister cl(cwt.at, radius, 1000000000, NULL);
+      for(cell *c: cl.lst)
+        res.push_back({c->land, c->wall, c->monst, c->item, c->landparam, c->mpdist});
+      sort(res.begin(), res.end());
+      return res;
+      };
+    auto orig = contents();
+    mapstream::loadMap(fname);
+    int t2 = SDL_GetTicks();
+    if(contents() != orig) errors++;
+    remove(fname.c_str());
+    println(hlog, "radius: ", radius, " cells: ", isize(orig), " generate and save: ", t1-t0, " ms load: ", t2-t1, " ms errors: ", errors);
+    if(errors) exit(1);
+    }
+
+  else if(argis("-bench-celllister")) {
+    /* compare celllister and hashed_celllister on a BFS of about N cells; also run hashed_celllisters in parallel */
+    start_game();
+    shift(); int n = argi();
+    int d;
+    { celllister cl(cwt.at, 1000, n, NULL); d = cl.dists.back() - 1; }
+    int t0 = SDL_GetTicks();
+    celllister cl(cwt.at, d, 1000000000, NULL);
+    int t1 = SDL_GetTicks();
+    hashed_celllister hcl(cwt.at, d, 1000000000, NULL);
+    int t2 = SDL_GetTicks();
+    if(cl.lst != hcl.lst || cl.dists != hcl.dists) errors++;
+    for(cell *c: cl.lst) if(hcl.getdist(c) != cl.getdist(c)) errors++;
+    /* a nested lister does not disturb the outer one */
+    { hashed_celllister inner(cwt.at, 2, 1000, NULL); if(!hcl.listed(inner.lst.back())) errors++; }
+    int threads = max(engine_threads, 2);
+    int total = run_parallel(threads, [&] (int a, int b) {
+      int res = 0;
+      for(int k=a; k<b; k++) { hashed_celllister pcl(cwt.at, d, 1000000000, NULL); res += isize(pcl.lst); }
+      return res;
+      });
+    int t3 = SDL_GetTicks();
+    if(total != threads * isize(cl.lst)) errors++;
+    println(hlog, "cells: ", isize(cl.lst), " celllister: ", t1-t0, " ms hashed: ", t2-t1, " ms ", threads, " parallel hashed: ", t3-t2, " ms errors: ", errors);
+    if(errors) exit(1);
+    }
+
+  else if(argis("-bench-dtable")) {
+    /* on a closed manifold: time the all-pairs distance table, check it against celllister from N sources, and time lookups */
+    start_game();
+    shift(); int n = argi();
+    vector<cell*> l = currentmap->allcells();
+    int t0 = SDL_GetTicks();
+    bounded_celldistance(l[0], l[0]);
+    int t1 = SDL_GetTicks();
+    int unknown = 0;
+    for(int k=0; k<n; k++) {
+      cell *c1 = l[hrand(isize(l))];
+      vector<cell*> lst;
+      vector<int> dists;
+      { celllister cl(c1, 100, 1000000, NULL); lst = cl.lst; dists = cl.dists; }
+      for(int i=0; i<isize(lst); i++) {
+        int d = bounded_celldistance(c1, lst[i]);
+        if(d == DISTANCE_UNKNOWN) unknown++;
+        else if(d != dists[i]) errors++;
+        }
+      }
+    int t2 = SDL_GetTicks();
+    int total = 0;
+    for(int k=0; k<1000000; k++) total += bounded_celldistance(l[hrand(isize(l))], l[hrand(isize(l))]);
+    int t3 = SDL_GetTicks();
+    println(hlog, "cells: ", isize(l), " table: ", t1-t0, " ms check: ", t2-t1, " ms 1M lookups: ", t3-t2, " ms (sum ", total, ") unknown: ", unknown, " errors: ", errors, " in: ", full_geometry_name());
+    if(errors) exit(1);
+    }
+
+  else if(argis("-bench-xlat")) {
+    /* translate the treasure and kill counts, as displayed by the item/kill menus, N times in each language; with and without the memo */
+    shift(); int n = argi();
+    dynamicval<int> dl(vid.language);
+    for(int memo: {0, 1}) {
+      dynamicval<int> dm(xlat_memo_size, memo ? 4096 : 0);
+      int t0 = SDL_GetTicks();
+      int len = 0;
+      for(int l=0; l<NUMLAN; l++) {
+        vid.language = l;
+        for(int k=0; k<n; k++) {
+          for(int i=1; i<ittypes; i++) len += isize(XLAT("treasure collected: %1", eItem(i))) + isize(XLAT1(iinf[i].name));
+          for(int i=1; i<motypes; i++) len += isize(XLAT("monsters destroyed: %1", eMonster(i)));
+          }
+        }
+      println(hlog, "memo: ", memo, " time: ", int(SDL_GetTicks() - t0), " ms, length: ", len);
+      }
+    }
+
+  else if(argis("-bench-relmatrix")) {
+    /* relative matrices between the origin and N cells found by random walks of length L, with and without jump pointers */
+    start_game();
+    shift(); int n = argi();
+    shift(); int len = argi();
+    vector<cell*> targets;
+    for(int i=0; i<n; i++) {
+      cell *c = cwt.at;
+      for(int k=0; k<len; k++) c = c->cmove(hrand(c->type));
+      targets.push_back(c);
+      }
+    vector<vector<transmatrix>> res;
+    for(int jumps: {-1, 16}) {
+      dynamicval<int> dj(relative_jump_threshold, jumps);
+      int t0 = SDL_GetTicks();
+      for(int it=0; it<10; it++) res.push_back(calc_relative_matrices(targets, cwt.at, C0));
+      println(hlog, "jump threshold: ", jumps, " time: ", int(SDL_GetTicks() - t0), " ms");
+      }
+    /* the entries grow exponentially with the distance, so compare relative to the largest one */
+    ld maxerr = 0;
+    for(int i=0; i<n; i++) {
+      transmatrix& T1 = res[0][i];
+      transmatrix& T2 = res.back()[i];
+      ld big = 0, err = 0;
+      for(int a=0; a<MXDIM; a++) for(int b=0; b<MXDIM; b++)
+        big = max(big, abs(T1[a][b])), err = max(err, abs(T1[a][b] - T2[a][b]));
+      maxerr = max(maxerr, err / big);
+      }
+    if(maxerr > 1e-6) errors++;
+    println(hlog, "cells: ", n, " distance: ", celldistance(cwt.at, targets.back()), " max relative error: ", maxerr, " errors: ", errors);
+    if(errors) exit(1);
+    }
+
   else if(argis("-partest", [] {
     hyperpoint h = point31(.01, .05, 0);
     if(LDIM == 3) h[2] = .015;
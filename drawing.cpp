@@ -2896,6 +2896,7 @@ EX void write_in_space(const shiftmatrix& V, int fsize, double size, const strin
     };
   
   for(int ch: chars) { 
+    require_glyph(f, ch);
     auto& c = f.chars[ch];
   
     pt(c.tx0, c.ty0, xpos, -th/2);
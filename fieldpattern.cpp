@@ -63,7 +63,91 @@ struct matrix : array<array<int, MAXMDIM>, MAXMDIM> {
       if(self[i][j] != B[i][j]) return self[i][j] < B[i][j];
     return false;
     }
-  
+
+  };
+
+/** \brief open-addressing hash table from matrices to group element ids
+ *
+ *  Used instead of map<matrix, int>: under EASY all entries are in (-Prime, Prime),
+ *  so a matrix is packed into 16-bit entries, and compared with a single array comparison.
+ *  Like map, operator[] inserts a missing matrix with value 0.
+ */
+struct matrix_index {
+  typedef array<short, MAXMDIM*MAXMDIM> packed;
+
+  vector<packed> keys;
+  vector<int> values;
+  vector<char> used;
+  int qty;
+
+  matrix_index() { clear(); }
+
+  static packed pack(const matrix& M) {
+    packed p;
+    p.fill(0);
+    int w = MWDIM;
+    for(int i=0; i<w; i++) for(int j=0; j<w; j++) p[i*MAXMDIM+j] = M[i][j];
+    return p;
+    }
+
+  static size_t hash_of(const packed& p) {
+    unsigned long long h = 0;
+    for(auto x: p) h = (h ^ (unsigned short) x) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 31);
+    }
+
+  int slot(const packed& p) const {
+    size_t mask = used.size() - 1;
+    size_t i = hash_of(p) & mask;
+    while(used[i] && keys[i] != p) i = (i+1) & mask;
+    return i;
+    }
+
+  void clear() {
+    qty = 0;
+    keys = vector<packed>(64);
+    values = vector<int>(64);
+    used = vector<char>(64, 0);
+    }
+
+  void grow() {
+    auto okeys = std::move(keys);
+    auto ovalues = std::move(values);
+    auto oused = std::move(used);
+    int n = 2 * isize(oused);
+    keys.resize(n); values.resize(n); used.assign(n, 0);
+    for(int i=0; i<isize(oused); i++) if(oused[i]) {
+      int s = slot(okeys[i]);
+      used[s] = true; keys[s] = okeys[i]; values[s] = ovalues[i];
+      }
+    }
+
+  /** the slot of p; if p is not present yet, it is added with value v, and added is set */
+  int locate(const packed& p, int v, bool& added) {
+    int s = slot(p);
+    added = !used[s];
+    if(added) {
+      if(2 * (qty+1) > isize(used)) { grow(); s = slot(p); }
+      used[s] = true; keys[s] = p; values[s] = v; qty++;
+      }
+    return s;
+    }
+
+  /** add M with value v unless already present; returns true if added */
+  bool insert(const matrix& M, int v) {
+    bool added;
+    locate(pack(M), v, added);
+    return added;
+    }
+
+  int count(const matrix& M) const { return used[slot(pack(M))]; }
+
+  int& operator [] (const matrix& M) {
+    bool added;
+    return values[locate(pack(M), 0, added)];
+    }
+
+  int size() const { return qty; }
   };
 #endif
 
@@ -150,9 +234,11 @@ struct fpattern {
     for(int i=0; i<MWDIM; i++) for(int k=0; k<MWDIM; k++) {
       int t = 0;
   #ifdef EASY
-      int tp = 0, tn = 0;
+      // same as summing mul(A[i][j], B[j][k]), but reduced only once
+      long long tp = 0, tn = 0;
       for(int j=0; j<MWDIM; j++) {
-        int val = mul(A[i][j], B[j][k]);
+        long long val = (long long) A[i][j] * B[j][k];
+        if(A[i][j] < 0 && B[j][k] < 0) val *= wsquare;
         if(val > 0) tp += val;
         else tn += val;
         }
@@ -167,7 +253,7 @@ struct fpattern {
     return res;
     }
   
-  map<matrix, int> matcode;
+  matrix_index matcode;
   vector<matrix> matrices;
   
   vector<string> qpaths;
@@ -200,17 +286,16 @@ struct fpattern {
     }
   
   void addas(const matrix& M, int i) {
-    if(!matcode.count(M)) {
-      matcode[M] = i;
+    if(matcode.insert(M, i)) {
       for(int j=0; j<isize(qcoords); j++)
         addas(mmul(M, qcoords[j]), i);
       }
     }
   
   void add(const matrix& M) {
-    if(!matcode.count(M)) {
-      int i = isize(matrices);
-      matcode[M] = i, matrices.push_back(M);
+    int i = isize(matrices);
+    if(matcode.insert(M, i)) {
+      matrices.push_back(M);
       for(int j=0; j<isize(qcoords); j++)
         addas(mmul(M, qcoords[j]), i);
       if(WDIM == 3) add(mmul(X, M));
@@ -227,6 +312,9 @@ struct fpattern {
   // 2D only
   vector<int> rrf; // rrf[i] equals gmul(i, rotations-1)
   vector<int> rpf; // rpf[i] equals gmul(i, rotations)
+
+  // 3D only
+  vector<int> pmul; // pmul[i] equals gmul(i, local_group), i.e., i*P
   
   matrix mpow(matrix M, int N) {
     while((N&1) == 0) N >>= 1, M = mmul(M, M);
@@ -335,7 +423,10 @@ struct fpattern {
   void add1(const matrix& M);
   void add1(const matrix& M, const transmatrix& Full);
   vector<matrix> generate_isometries3();
+  void need_fulls();
   int solve3();
+  /** solve3 in the field Z_p (sq=0) or Z_p[w] where w^2 = sq */
+  int solve3_in(int p, int sq);
   bool generate_all3();
   
   #if CAP_THREAD
@@ -349,6 +440,7 @@ struct fpattern {
 
 #if CAP_THREAD && MAXMDIM >= 4
 struct discovery {
+  /** the field most recently tried, for display; the actual experiments are local to the worker threads */
   fpattern experiment;
   std::shared_ptr<std::thread> discoverer;
   std::mutex lock;
@@ -363,7 +455,7 @@ struct discovery {
   void suspend();
   void check_suspend();
   void schedule_destruction();
-  void discovered();
+  void discovered(fpattern& e);
   ~discovery();
   };
 #endif
@@ -475,29 +567,35 @@ vector<matrix> fpattern::generate_isometries3() {
   }
 
 void fpattern::add1(const matrix& M) {
-  if(!matcode.count(M)) {
-    int i = isize(matrices);
-    matcode[M] = i, matrices.push_back(M);
-    }
+  if(matcode.insert(M, isize(matrices)))
+    matrices.push_back(M);
   }
 
 void fpattern::add1(const matrix& M, const transmatrix& Full) {
-  if(!matcode.count(M)) {
-    int i = isize(matrices);
-    matcode[M] = i, matrices.push_back(M), fullv.push_back(Full);
-    }
+  if(matcode.insert(M, isize(matrices)))
+    matrices.push_back(M), fullv.push_back(Full);
   }
 #endif
 
 map<unsigned,int> hash_found;
 
+/** count the hashes generated, for DF_FIELD; the discovery threads may call this concurrently */
+int count_hash(unsigned hashv) {
+  #if CAP_THREAD
+  static std::mutex lock;
+  std::unique_lock<std::mutex> lk(lock);
+  #endif
+  return ++hash_found[hashv];
+  }
+
 unsigned fpattern::compute_hash() {
   unsigned hashv = 0;
   int iR = matcode[R];
   int iP = matcode[P];
   int iX = matcode[X];
+  bool have_pmul = iP == local_group && isize(pmul) == isize(matrices);
   for(int i=0; i<isize(matrices); i++) {
-    hashv = 3 * hashv + gmul(i, iP) + 7 * gmul(i, iR);
+    hashv = 3 * hashv + (have_pmul ? pmul[i] : gmul(i, iP)) + 7 * gmul(i, iR);
     if(MWDIM == 4) hashv += 11 * gmul(i, iX);
     }
   return hashv;
@@ -506,11 +604,12 @@ unsigned fpattern::compute_hash() {
 #if MAXMDIM >= 4
 bool fpattern::generate_all3() {
 
-  reg3::generate_fulls();
+  need_fulls();
   err = 0;
 
   matrices.clear();
   matcode.clear();
+  pmul.clear();
   add1(Id);
   fullv = {hr::Id};
   for(int i=0; i<isize(matrices); i++) {
@@ -525,11 +624,12 @@ bool fpattern::generate_all3() {
     matrix E = mmul(matrices[i], P);
     if(!matcode.count(E))
       for(int j=0; j<local_group; j++) add1(mmul(E, matrices[j]));
+    pmul.push_back(matcode[E]);
     if(err) return false;
     if(isize(matrices) >= limitv) { println(hlog, "limitv exceeded"); return false; }
     }
   hashv = compute_hash();
-  DEBB(DF_FIELD, ("all = ", isize(matrices), "/", local_group, " = ", isize(matrices) / local_group, " hash = ", hashv, " count = ", ++hash_found[hashv]));
+  DEBB(DF_FIELD, ("all = ", isize(matrices), "/", local_group, " = ", isize(matrices) / local_group, " hash = ", hashv, " count = ", count_hash(hashv)));
   
   if(use_quotient_fp) 
     generate_quotientgroup();  
@@ -590,6 +690,7 @@ void fpattern::generate_quotientgroup() {
     for(int i=0; i<MS; i++)
       matcode[matrices[i]] = new_id[i];
     matrices = std::move(new_matrices);
+    pmul.clear();
     println(hlog, "size matrices = ", isize(matrices), " size matcode = ", isize(matcode));
     println(hlog, tie(P, R, X));
     
@@ -602,9 +703,17 @@ void fpattern::generate_quotientgroup() {
 
 EX purehookset hooks_solve3;
 
+void fpattern::need_fulls() {
+  #if CAP_THREAD
+  /* discovery threads share cgi: discovery::activate generates these before starting them */
+  if(dis) return;
+  #endif
+  reg3::generate_fulls();
+  }
+
 int fpattern::solve3() {
 
-  reg3::generate_fulls();
+  need_fulls();
   
   DEBB(DF_FIELD, ("generating isometries for ", Field));
   
@@ -627,28 +736,34 @@ int fpattern::solve3() {
     
   DEBB(DF_FIELD, ("field = ", Field, " #P = ", isize(possible_P), " #X = ", isize(possible_X), " #R = ", isize(possible_R), " r_order = ", cgi.r_order, " xp_order = ", cgi.xp_order));
                                                                                                                                
-  for(auto& xX: possible_X)
-  for(auto& xP: possible_P) if(check_order(mmul(xP, xX), cgi.xp_order)) 
-  for(auto& xR: possible_R) if(check_order(mmul(xR, xX), cgi.rx_order)) {
-
-    err = 0;
-    if(mmul(xX, xP) != mmul(xR, mmul(mmul(xP, xX), xR))) continue;
-    if(err) continue;
-
-    #if CAP_THREAD && MAXMDIM >= 4
-    if(dis) dis->check_suspend();
-    if(dis && dis->stop_it) return 0;
-    #endif
+  for(auto& xX: possible_X) {
+    // the condition on R does not depend on P
+    vector<matrix*> good_R;
+    for(auto& xR: possible_R) if(check_order(mmul(xR, xX), cgi.rx_order)) good_R.push_back(&xR);
+
+    for(auto& xP: possible_P) if(check_order(mmul(xP, xX), cgi.xp_order))
+    for(auto pR: good_R) {
+      auto& xR = *pR;
+
+      err = 0;
+      if(mmul(xX, xP) != mmul(xR, mmul(mmul(xP, xX), xR))) continue;
+      if(err) continue;
+
+      #if CAP_THREAD && MAXMDIM >= 4
+      if(dis) dis->check_suspend();
+      if(dis && dis->stop_it) return 0;
+      #endif
 
-    P = xP; R = xR; X = xX;
-    if(!generate_all3()) continue;
-    callhooks(hooks_solve3);
-    #if CAP_THREAD && MAXMDIM >= 4
-    if(dis) { dis->discovered(); continue; }
-    #endif
-    if(force_hash && hashv != force_hash) continue;
-    cmb++;
-    goto ok;
+      P = xP; R = xR; X = xX;
+      if(!generate_all3()) continue;
+      callhooks(hooks_solve3);
+      #if CAP_THREAD && MAXMDIM >= 4
+      if(dis) { dis->discovered(*this); continue; }
+      #endif
+      if(force_hash && hashv != force_hash) continue;
+      cmb++;
+      goto ok;
+      }
     }
 
   ok:
@@ -657,6 +772,14 @@ int fpattern::solve3() {
   
   return cmb;
   }
+
+int fpattern::solve3_in(int p, int sq) {
+  set_field(p, sq);
+  rotations = 4;
+  local_group = 24;
+  dual = 0;
+  return solve3();
+  }
 #endif
 
 void fpattern::set_field(int p, int sq) {
@@ -666,6 +789,17 @@ void fpattern::set_field(int p, int sq) {
   for(int a=0; a<MWDIM; a++) for(int b=0; b<MWDIM; b++) Id[a][b] = a==b?1:0;
   }
 
+/** the smallest non-square modulo p, used as w^2 in Z_p[w] */
+int smallest_nonsquare(int p) {
+  int w;
+  for(w=1; w<p; w++) {
+    int roots = 0;
+    for(int a=0; a<p; a++) if((a*a)%p == w) roots++;
+    if(!roots) break;
+    }
+  return w;
+  }
+
 int fpattern::solve() {
   
   for(int a=0; a<MWDIM; a++) for(int b=0; b<MWDIM; b++) Id[a][b] = a==b?1:0;
@@ -682,13 +816,7 @@ int fpattern::solve() {
     if(pw>3) break;
     Field = pw==1? Prime : Prime*Prime;
     
-    if(pw == 2) {
-      for(wsquare=1; wsquare<Prime; wsquare++) {
-        int roots = 0;
-        for(int a=0; a<Prime; a++) if((a*a)%Prime == wsquare) roots++;
-        if(!roots) break;
-        }
-      } else wsquare = 0;
+    wsquare = pw == 2 ? smallest_nonsquare(Prime) : 0;
 
     #if MAXMDIM >= 4
     if(WDIM == 3) {
@@ -858,7 +986,7 @@ void fpattern::build() {
     printf("Solved %s as matrix of order %d\n", qpaths[i].c_str(), order(M));
     }
   
-  matcode.clear(); matrices.clear();
+  matcode.clear(); matrices.clear(); pmul.clear();
   add(Id);
   if(isize(matrices) != local_group) { printf("Error: rotation crash #1 (%d)\n", isize(matrices)); exit(1); }
   
@@ -952,6 +1080,10 @@ int fpattern::getdist(pair<int,bool> a, pair<int,bool> b) {
  
 int fpattern::dijkstra(vector<char>& dists, vector<int> indist[MAXDIST]) {
   int N = isize(matrices);
+  if(WDIM == 3 && isize(pmul) != N) {
+    pmul.resize(N);
+    for(int i=0; i<N; i++) pmul[i] = gmul(i, local_group);
+    }
   dists.resize(N);
   for(int i=0; i<N; i++) dists[i] = MAXDIST-1;
   int maxd = 0;
@@ -965,7 +1097,7 @@ int fpattern::dijkstra(vector<char>& dists, vector<int> indist[MAXDIST]) {
     for(int q=0; q<lg; q++) {
       dists[at] = i;
       if(WDIM == 3)
-        indist[i+1].push_back(gmul(at, local_group));
+        indist[i+1].push_back(pmul[at]);
       else if(PURE) // todo-variation: PURE here?
         indist[i+1].push_back(connections[at]);
       else {
@@ -1528,12 +1660,31 @@ EX map<string, discovery> discoveries;
 
 void discovery::activate() {
   if(!discoverer) {
+    reg3::generate_fulls();
     discoverer = std::make_shared<std::thread> ( [this] {
-      for(int p=2; p<100; p++) {
-        experiment.Prime = p;
-        experiment.solve();
-        if(stop_it) break;
+      /* the candidate fields: Z_p, and also Z_p[w] for p <= limitsq */
+      vector<pair<int, int>> fields;
+      for(int p=2; p<100; p++) if(isprime(p)) {
+        fields.emplace_back(p, 0);
+        if(p <= limitsq) fields.emplace_back(p, smallest_nonsquare(p));
         }
+      std::atomic<int> next(0);
+      vector<std::thread> workers;
+      for(int t=0; t<engine_threads; t++) workers.emplace_back([&] {
+        fpattern e(0);
+        e.dis = this;
+        while(!stop_it) {
+          int id = next++;
+          if(id >= isize(fields)) break;
+          if(1) {
+            std::unique_lock<std::mutex> lk(lock);
+            experiment.Prime = fields[id].first;
+            experiment.wsquare = fields[id].second;
+            }
+          e.solve3_in(fields[id].first, fields[id].second);
+          }
+        });
+      for(auto& w: workers) w.join();
       });
     }
   if(is_suspended) {
@@ -1541,14 +1692,16 @@ void discovery::activate() {
       std::unique_lock<std::mutex> lk(lock);
       is_suspended = false;
       }
-    cv.notify_one();
+    cv.notify_all();
     }
   }
 
-void discovery::discovered() {
+void discovery::discovered(fpattern& e) {
   std::unique_lock<std::mutex> lk(lock);
-  auto& e = experiment;
-  hashes_found[e.hashv] = make_tuple(e.Prime, e.wsquare, e.R, e.P, e.X, isize(e.matrices) / e.local_group);
+  /* fields finish in any order; keep the result from the last field in the sequential order */
+  auto it = hashes_found.find(e.hashv);
+  if(it != hashes_found.end() && make_pair(get<0>(it->second), get<1>(it->second)) > make_pair(e.Prime, e.wsquare)) return;
+  hashes_found[e.hashv] =make_tuple(e.Prime, e.wsquare, e.R, e.P, e.X, isize(e.matrices) / e.local_group);
   }
 
 void discovery::suspend() { is_suspended = true; }
@@ -1277,6 +1277,9 @@ EX map<string, geometry_information> cgis;
 
 EX int last_texture_step;
 
+/** the number of unused geometry_information structures kept in memory; returning to one of them does not regenerate its shapes */
+EX int cgi_cache_size = 3;
+
 int ntimestamp;
 
 EX hookset<void(string&)> hooks_cgi_string;
@@ -1406,7 +1409,7 @@ EX void check_cgi() {
   if(arcm::alt_cgip[1]) arcm::alt_cgip[1]->timestamp = ntimestamp;
   #endif
   
-  int limit = 3;
+  int limit = cgi_cache_size;
   for(auto& t: cgis) if(t.second.use_count || t.second.timestamp == ntimestamp) limit++;
   if(isize(cgis) > limit) {
     vector<pair<int, string>> timestamps;
@@ -91,6 +91,14 @@ EX transmatrix calc_relative_matrix(cell *c2, cell *c1, const hyperpoint& hint)
   return currentmap->relative_matrix(c2, c1, hint);
   }
 
+/** calc_relative_matrix(c2, c1, hint) for every c2 in targets; in hyperbolic tilings, the jump pointers of the ancestors of c1 are computed once and shared by all the queries */
+EX vector<transmatrix> calc_relative_matrices(const vector<cell*>& targets, cell *c1, const hyperpoint& hint) {
+  vector<transmatrix> res;
+  res.reserve(isize(targets));
+  for(cell *c2: targets) res.push_back(currentmap->relative_matrix(c2, c1, hint));
+  return res;
+  }
+
 // target, source, direction from source to target
 
 #if CAP_GP
@@ -126,6 +134,82 @@ transmatrix hrmap_standard::relative_matrixc(cell *c2, cell *c1, const hyperpoin
   return relative_matrix_via_masters(c2, c1, hint);
   }
 
+/** the number of jump pointers kept by hrmap_standard; the cache is cleared when it grows above this */
+EX int relative_jump_cache_size = 100000;
+
+/** relative_matrixh climbs this many steps one by one before switching to jump pointers; negative to never use them */
+EX int relative_jump_threshold = 16;
+
+/** the depth of the jump target of a heptagon at depth d: the lowest set bit of d is cleared, so that the targets depend only on the depth */
+int jump_depth(int d) {
+  int D = d + (1<<30);
+  return (D & (D-1)) - (1<<30);
+  }
+
+/** move(0) leads to the parent, except in the origin */
+heptagon *tree_parent(heptagon *h) {
+  heptagon *p = h->move(0);
+  return p && p->distance < h->distance ? p : nullptr;
+  }
+
+const heptagon_jump& hrmap_standard::get_jump(heptagon *h) {
+  auto it = jumps.find(h);
+  if(it != jumps.end()) return it->second;
+  /* compute the missing jump pointers from the top, so that the ancestors are always known */
+  vector<heptagon*> chain;
+  for(heptagon *h1 = h; h1 && !jumps.count(h1); h1 = tree_parent(h1)) chain.push_back(h1);
+  for(int i=isize(chain)-1; i>=0; i--) {
+    heptagon *h1 = chain[i];
+    heptagon_jump j {tree_parent(h1), Id};
+    if(j.target) j.T = adj(h1, 0);
+    int t = jump_depth(h1->distance);
+    while(j.target && j.target->distance > t) {
+      auto& j1 = jumps.at(j.target);
+      if(j1.target && j1.target->distance >= t)
+        j.T = j.T * j1.T, j.target = j1.target;
+      else
+        j.T = j.T * adj(j.target, 0), j.target = tree_parent(j.target);
+      }
+    jumps[h1] = j;
+    }
+  return jumps.at(h);
+  }
+
+/** relative_matrixh in the tree of a hyperbolic tiling, using jump pointers: O(log(distance)) matrix multiplications instead of O(distance) */
+transmatrix hrmap_standard::relative_matrix_jumps(heptagon *h2, heptagon *h1, transmatrix gm, transmatrix where) {
+  if(isize(jumps) > relative_jump_cache_size) jumps.clear();
+  while(h2->distance > h1->distance) {
+    auto& j = get_jump(h2);
+    if(j.target && j.target->distance >= h1->distance)
+      where = iso_inverse(j.T) * where, h2 = j.target;
+    else
+      where = iadj(h2, 0) * where, h2 = h2->move(0);
+    }
+  while(h1->distance > h2->distance) {
+    auto& j = get_jump(h1);
+    if(j.target && j.target->distance >= h2->distance)
+      gm = gm * j.T, h1 = j.target;
+    else
+      gm = gm * adj(h1, 0), h1 = h1->move(0);
+    }
+  /* same depth, so the jump targets are at the same depth too */
+  while(h1 != h2) {
+    for(int d=0; d<h1->type; d++) if(h1->move(d) == h2)
+      return gm * adj(h1, d) * where;
+    auto& j1 = get_jump(h1);
+    auto& j2 = get_jump(h2);
+    if(j1.target && j2.target && j1.target != j2.target) {
+      gm = gm * j1.T, h1 = j1.target;
+      where = iso_inverse(j2.T) * where, h2 = j2.target;
+      }
+    else {
+      gm = gm * adj(h1, 0), h1 = h1->move(0);
+      where = iadj(h2, 0) * where, h2 = h2->move(0);
+      }
+    }
+  return gm * where;
+  }
+
 transmatrix hrmap_standard::relative_matrixh(heptagon *h2, heptagon *h1, const hyperpoint& hint) {
 
   transmatrix gm = Id, where = Id;
@@ -188,6 +272,8 @@ transmatrix hrmap_standard::relative_matrixh(heptagon *h2, heptagon *h1, const h
       if(bestv.empty()) hbdist.erase(hbdist.begin());
       }
     #endif
+    else if(hyperbolic && !quotient && relative_jump_threshold >= 0 && steps > relative_jump_threshold)
+      return relative_matrix_jumps(h2, h1, gm, where);
     else if(h1->distance < h2->distance) {
       where = iadj(h2, 0) * where;
       h2 = h2->move(0);
@@ -539,8 +625,8 @@ transmatrix hrmap_standard::adj(cell *c, int i) {
     if(h == h1)
       return T * U;
     else if(gp::do_adjm && !fake::in()) {
-      if(gp::gp_adj.count(make_pair(c,i))) {
-        return T * gp::get_adj(c,i) * U;
+      if(auto A = gp::find_adj(c, i)) {
+        return T * *A * U;
         }
       if(first) { first = false; println(hlog, "no gp_adj"); }
       }
@@ -274,10 +274,8 @@ EX namespace gp {
         }
       }
     if(do_adjm) {
-      get_adj(wcw.at, wcw.spin) = inverse(wc.adjm) * wc1.adjm;
-      get_adj(wcw1.at, wcw1.spin) = inverse(wc1.adjm) * wc.adjm;
-      if(geom3::flipped) gp_swapped.emplace(wcw.at, wcw.spin);
-      if(geom3::flipped) gp_swapped.emplace(wcw1.at, wcw1.spin);
+      set_adj(wcw.at, wcw.spin, inverse(wc.adjm) * wc1.adjm);
+      set_adj(wcw1.at, wcw1.spin, inverse(wc1.adjm) * wc.adjm);
       }
     }
 
@@ -286,10 +284,155 @@ EX namespace gp {
     conn1(at + eudir(dir), fixg6(dir+SG3), fixg6(dir));
     }
   
+  /* In quotient and spherical maps (do_adjm), we need the matrices between the master frames of adjacent cells.
+   * These depend only on the local configurations (get_code) of both cells and the directions, so they are kept in
+   * a fixed-size table keyed by that. New matrices are first put in gp_adj_new, and moved to the table by
+   * compact_adj() once their cells are fully connected; the ones which do not agree with the table stay in gp_adj.
+   */
+
+  #if HDR
+  struct adj_entry {
+    long long key;
+    bool swapped;
+    transmatrix T;
+    };
+  #endif
+
+  static constexpr int ADJ_TABLE_BITS = 12;
+
+  EX vector<adj_entry> gp_adj_table;
+  EX int gp_adj_table_used;
+
+  /** exceptions, i.e., matrices not agreeing with gp_adj_table */
   EX map<pair<cell*, int>, transmatrix> gp_adj;
+  /** matrices not yet moved to gp_adj_table */
+  EX map<pair<cell*, int>, transmatrix> gp_adj_new;
+  /** entries of gp_adj and gp_adj_new computed in the flipped mode */
   EX set<pair<cell*, int>> gp_swapped;
-  
-  EX transmatrix& get_adj(cell *c, int i) { return gp_adj[make_pair(c,i)]; }
+
+  /** get_code(get_local_info(c)) without allocation, or -1 if the path to the master is not known yet */
+  int shape_code(cell *c) {
+    if(c == c->master->c7) return get_code(get_local_info(c));
+    array<signed char, 2 * GOLDBERG_LIMIT> dirs;
+    int q = 0;
+    while(c != c->master->c7) {
+      if(!c->move(0) || q == isize(dirs)) return -1;
+      dirs[q++] = c->c.spin(0);
+      c = c->move(0);
+      }
+    local_info li;
+    li.first_dir = dirs[0];
+    li.last_dir = dirs[q-1];
+    loc at(0,0);
+    int dir = 0;
+    at = at + eudir(dir);
+    for(int k=q-2; k>=0; k--) {
+      dir += dirs[k] + SG3;
+      at = at + eudir(dir);
+      }
+    li.relative = at;
+    li.total_dir = dir + SG3;
+    return get_code(li);
+    }
+
+  /** the key of (c,i) in gp_adj_table, or -1 if it cannot be computed (yet); it consists of the shape codes of both cells and the directions of the edge */
+  long long adj_key(cell *c, int i) {
+    if(INVERSE || i >= 32) return -1;
+    cell *c1 = c->move(i);
+    if(!c1) return -1;
+    int spin = c->c.spin(i);
+    int code = shape_code(c), code1 = shape_code(c1);
+    if(spin >= 32 || code == -1 || code1 == -1) return -1;
+    return ((long long)(code) << 32) | (code1 << 10) | (spin << 5) | i;
+    }
+
+  adj_entry *adj_slot(long long key, bool create) {
+    if(gp_adj_table.empty()) {
+      if(!create) return nullptr;
+      gp_adj_table.resize(1 << ADJ_TABLE_BITS);
+      for(auto& e: gp_adj_table) e.key = -1;
+      gp_adj_table_used = 0;
+      }
+    int mask = (1 << ADJ_TABLE_BITS) - 1;
+    for(int h = ((unsigned long long)(key) * 0x9E3779B97F4A7C15ull) >> (64 - ADJ_TABLE_BITS);; h = (h+1) & mask) {
+      auto& e = gp_adj_table[h];
+      if(e.key == key) return &e;
+      if(e.key != -1) continue;
+      /* keep the table at most 3/4 full; further configurations go to gp_adj */
+      if(!create || gp_adj_table_used * 4 >= 3 << ADJ_TABLE_BITS) return nullptr;
+      e.key = key; e.swapped = geom3::flipped; e.T = Id;
+      gp_adj_table_used++;
+      return &e;
+      }
+    }
+
+  /** the adjacency matrix for (c,i), or nullptr if not known */
+  EX const transmatrix *find_adj(cell *c, int i) {
+    auto p = make_pair(c, i);
+    if(!gp_adj_new.empty()) {
+      auto it = gp_adj_new.find(p);
+      if(it != gp_adj_new.end()) return &it->second;
+      }
+    if(!gp_adj.empty()) {
+      auto it = gp_adj.find(p);
+      if(it != gp_adj.end()) return &it->second;
+      }
+    auto key = adj_key(c, i);
+    if(key == -1) return nullptr;
+    auto e = adj_slot(key, false);
+    return e ? &e->T : nullptr;
+    }
+
+  EX transmatrix get_adj(cell *c, int i) {
+    auto T = find_adj(c, i);
+    return T ? *T : Id;
+    }
+
+  EX void set_adj(cell *c, int i, const transmatrix& T) {
+    auto p = make_pair(c, i);
+    gp_adj_new[p] = T;
+    if(geom3::flipped) gp_swapped.insert(p);
+    else gp_swapped.erase(p);
+    }
+
+  /** move the entries of gp_adj_new to gp_adj_table or gp_adj */
+  EX void compact_adj() {
+    for(auto it = gp_adj_new.begin(); it != gp_adj_new.end();) {
+      auto p = it->first;
+      auto key = adj_key(p.first, p.second);
+      if(key == -1) { it++; continue; }
+      bool swapped = gp_swapped.count(p);
+      auto e = adj_slot(key, false);
+      if(!e && (e = adj_slot(key, true))) e->T = it->second, e->swapped = swapped;
+      if(e && e->swapped == swapped && eqmatrix(e->T, it->second, 1e-6)) {
+        gp_adj.erase(p);
+        gp_swapped.erase(p);
+        }
+      else
+        gp_adj[p] = it->second;
+      it = gp_adj_new.erase(it);
+      }
+    }
+
+  EX void clear_adj() {
+    gp_adj.clear();
+    gp_adj_new.clear();
+    gp_adj_table.clear();
+    gp_adj_table_used = 0;
+    }
+
+  /** called on dimension change: restore the matrices computed in the flipped mode */
+  EX void unswap_adj() {
+    for(auto& p: gp_swapped) {
+      if(gp_adj.count(p)) swapmatrix(gp_adj[p]);
+      if(gp_adj_new.count(p)) swapmatrix(gp_adj_new[p]);
+      }
+    gp_swapped.clear();
+    for(auto& e: gp_adj_table) if(e.key != -1 && e.swapped) {
+      swapmatrix(e.T);
+      e.swapped = false;
+      }
+    }
 
   goldberg_mapping_t& set_heptspin(loc at, heptspin hs) {
     auto& ac0 = get_mapping(at);
@@ -1451,6 +1594,8 @@ EX namespace gp {
 
 auto hooksw = addHook(hooks_swapdim, 100, [] {
   for(auto& p: gp_adj) swapmatrix(p.second);
+  for(auto& p: gp_adj_new) swapmatrix(p.second);
+  for(auto& e: gp_adj_table) if(e.key != -1) swapmatrix(e.T);
   });
 
     
@@ -111,24 +111,33 @@ inline void hwrite(hstream& hs, const string& s) {
     }
   else 
     hs.write_char(isize(s));    
-  for(char c: s) hs.write_char(c);
+  hs.write_chars(s.data(), s.size());
   }
 inline void hread(hstream& hs, string& s) {
-  s = ""; int l = (unsigned char) hs.read_char(); 
+  int l = (unsigned char) hs.read_char(); 
   if(l == 255) l = hs.get<int>();
-  for(int i=0; i<l; i++) s += hs.read_char();
+  s.resize(l);
+  if(l) hs.read_chars(&s[0], l);
   }
 inline void hwrite(hstream& hs, const ld& h) { double d = h; hs.write_chars((char*) &d, sizeof(double)); }
 inline void hread(hstream& hs, ld& h) { double d; hs.read_chars((char*) &d, sizeof(double)); h = d; }
   
-template<class T, size_t X> void hwrite(hstream& hs, const array<T, X>& a) { for(auto &ae: a) hwrite(hs, ae); }
-template<class T, size_t X> void hread(hstream& hs, array<T, X>& a) { for(auto &ae: a) hread(hs, ae); }
+/** types for which hwrite writes just the bytes of the value, so that their vectors and arrays can be copied in bulk (vector<bool> is not contiguous) */
+template<class T> struct hstream_raw : std::integral_constant<bool,
+  (std::is_integral<T>::value || std::is_enum<T>::value || std::is_same<T, double>::value) && !std::is_same<T, bool>::value> {};
+
+template<class T, size_t X, typename std::enable_if<!hstream_raw<T>::value, int>::type = 0> void hwrite(hstream& hs, const array<T, X>& a) { for(auto &ae: a) hwrite(hs, ae); }
+template<class T, size_t X, typename std::enable_if<!hstream_raw<T>::value, int>::type = 0> void hread(hstream& hs, array<T, X>& a) { for(auto &ae: a) hread(hs, ae); }
+template<class T, size_t X, typename std::enable_if<hstream_raw<T>::value, int>::type = 0> void hwrite(hstream& hs, const array<T, X>& a) { hs.write_chars((const char*) a.data(), sizeof(T) * X); }
+template<class T, size_t X, typename std::enable_if<hstream_raw<T>::value, int>::type = 0> void hread(hstream& hs, array<T, X>& a) { hs.read_chars((char*) a.data(), sizeof(T) * X); }
 
 inline void hread(hstream& hs, hyperpoint& h) { for(int i=0; i<MDIM; i++) hread(hs, h[i]); }
 inline void hwrite(hstream& hs, hyperpoint h) { for(int i=0; i<MDIM; i++) hwrite(hs, h[i]); }
 
-template<class T> void hwrite(hstream& hs, const vector<T>& a) { hwrite<int>(hs, isize(a)); for(auto &ae: a) hwrite(hs, ae); }
-template<class T> void hread(hstream& hs, vector<T>& a) { a.resize(hs.get<int>()); for(auto &ae: a) hread(hs, ae); }
+template<class T, typename std::enable_if<!hstream_raw<T>::value, int>::type = 0> void hwrite(hstream& hs, const vector<T>& a) { hwrite<int>(hs, isize(a)); for(auto &ae: a) hwrite(hs, ae); }
+template<class T, typename std::enable_if<!hstream_raw<T>::value, int>::type = 0> void hread(hstream& hs, vector<T>& a) { a.resize(hs.get<int>()); for(auto &ae: a) hread(hs, ae); }
+template<class T, typename std::enable_if<hstream_raw<T>::value, int>::type = 0> void hwrite(hstream& hs, const vector<T>& a) { hwrite<int>(hs, isize(a)); hs.write_chars((const char*) a.data(), sizeof(T) * a.size()); }
+template<class T, typename std::enable_if<hstream_raw<T>::value, int>::type = 0> void hread(hstream& hs, vector<T>& a) { a.resize(hs.get<int>()); hs.read_chars((char*) a.data(), sizeof(T) * a.size()); }
 
 template<class T, class U> void hwrite(hstream& hs, const map<T,U>& a) { 
   hwrite<int>(hs, isize(a)); for(auto &ae: a) hwrite(hs, ae.first, ae.second);
@@ -150,15 +159,16 @@ struct hstream_exception : hr_exception {
   hstream_exception(const std::string &s) : hr_exception(s) {}
   };
 
+/** file stream; single characters go through the stdio buffer (enlarged for files opened by the constructor), so f can still be used directly */
 struct fhstream : hstream {
   FILE *f;
   explicit fhstream() { f = NULL; }
-  explicit fhstream(const string pathname, const char *mode) { f = fopen(pathname.c_str(), mode); vernum = VERNUM_HEX; }
+  explicit fhstream(const string pathname, const char *mode) { f = fopen(pathname.c_str(), mode); if(f) setvbuf(f, NULL, _IOFBF, 1<<16); vernum = VERNUM_HEX; }
   ~fhstream() { if(f) fclose(f); }
-  void write_char(char c) override { write_chars(&c, 1); }
-  void write_chars(const char* c, size_t i) override { if(fwrite(c, i, 1, f) != 1) throw hstream_exception(); }
-  void read_chars(char* c, size_t i) override { if(fread(c, i, 1, f) != 1) throw hstream_exception(); }
-  char read_char() override { char c; read_chars(&c, 1); return c; }
+  void write_char(char c) override { if(putc(c, f) == EOF) throw hstream_exception(); }
+  void write_chars(const char* c, size_t i) override { if(i && fwrite(c, i, 1, f) != 1) throw hstream_exception(); }
+  void read_chars(char* c, size_t i) override { if(i && fread(c, i, 1, f) != 1) throw hstream_exception(); }
+  char read_char() override { int c = getc(f); if(c == EOF) throw hstream_exception(); return c; }
   void flush() override { fflush(f); }
   };
 
@@ -167,7 +177,12 @@ struct shstream : hstream {
   int pos;
   explicit shstream(const string& t = "") : s(t) { pos = 0; vernum = VERNUM_HEX; }
   void write_char(char c) override { s += c; }
+  void write_chars(const char* c, size_t q) override { s.append(c, q); }
   char read_char() override { if(pos == isize(s)) throw hstream_exception(); return s[pos++]; }
+  void read_chars(char* c, size_t q) override {
+    if(q > size_t(isize(s) - pos)) throw hstream_exception();
+    memcpy(c, s.data() + pos, q); pos += q;
+    }
   };
 
 inline void print(hstream& hs) {}
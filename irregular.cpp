@@ -26,6 +26,7 @@ struct cellinfo {
   cell *owner;
   map<cell*, transmatrix> relmatrices;
   vector<hyperpoint> jpoints;
+  vector<int> jindex;
   hyperpoint p;
   transmatrix pusher, rpusher;
   vector<int> neid;
@@ -74,10 +75,31 @@ EX int bitruncations_performed = 0;
 
 int black_adjacent, white_three;
 
+/** base cells in distance at most 2 from the given base cell */
+map<cell*, vector<cell*>> vicinity;
+
+/** Voronoi neighbors of cells owned by c are owned by adjacent base cells (otherwise the map is rejected),
+ *  so only the base cells returned here need to be considered; this keeps the construction near-linear */
+vector<cell*>& base_vicinity(cell *c) {
+  auto& v = vicinity[c];
+  if(v.empty()) {
+    v.push_back(c);
+    int from = 0;
+    for(int r=0; r<2; r++) {
+      int to = isize(v);
+      for(int k=from; k<to; k++)
+        forCellCM(c1, v[k])
+          if(std::find(v.begin(), v.end(), c1) == v.end())
+            v.push_back(c1);
+      from = to;
+      }
+    }
+  return v;
+  }
+
 void set_relmatrices(cellinfo& ci) {
-  auto& all = base->allcells();
   ci.relmatrices.clear();
-  for(auto c0: all) ci.relmatrices[c0] = calc_relative_matrix(c0, ci.owner, ci.p);
+  for(auto c0: base_vicinity(ci.owner)) ci.relmatrices[c0] = calc_relative_matrix(c0, ci.owner, ci.p);
   }
 
 void rebase(cellinfo& ci) {
@@ -89,20 +111,70 @@ void rebase(cellinfo& ci) {
     }
   }
 
+/** compute jpoints, i.e., the cells owned by the base vicinity, relative to each cell */
 void compute_jpoints() {
-  for(int i=0; i<isize(cells); i++) {
-    auto &ci = cells[i];
+  run_parallel(isize(cells), [] (int a, int b) {
+    for(int i=a; i<b; i++) {
+      auto &ci = cells[i];
 
-    ci.pusher = rgpushxto0(ci.p);
-    ci.rpusher = gpushxto0(ci.p);
-    
-    ci.jpoints.clear();
+      ci.pusher = rgpushxto0(ci.p);
+      ci.rpusher = gpushxto0(ci.p);
+
+      ci.jpoints.clear();
+      ci.jindex.clear();
 
-    for(int j=0; j<isize(cells); j++) {
-      auto &cj = cells[j];
-      ci.jpoints.push_back(ci.rpusher * ci.relmatrices[cj.owner] * cj.p);
+      for(auto& rm: ci.relmatrices) {
+        auto it = cells_of_heptagon.find(rm.first->master);
+        if(it == cells_of_heptagon.end()) continue;
+        for(int j: it->second) {
+          ci.jindex.push_back(j);
+          ci.jpoints.push_back(ci.rpusher * rm.second * cells[j].p);
+          }
+        }
       }
+    return 0;
+    });
+  }
+
+/** compute the Voronoi cell of cells[i], based on its jpoints */
+void compute_voronoi_cell(int i) {
+  auto &p1 = cells[i];
+
+  p1.vertices.clear();
+  p1.neid.clear();
+
+  int J = isize(p1.jpoints);
+  int j = -1;
+
+  for(int k=0; k<J; k++) if(p1.jindex[k] != i) {
+    if(j == -1 || hdist(p1.jpoints[k], C0) < hdist(p1.jpoints[j], C0))
+      j = k;
     }
+  if(j == -1) return;
+
+  hyperpoint t = mid(p1.jpoints[j], C0);
+  int j0 = j;
+  int oldj = j;
+  do {
+    int best_k = -1;
+    hyperpoint best_h;
+    for(int k=0; k<J; k++) if(p1.jindex[k] != i && k != j && k != oldj) {
+      hyperpoint h = circumscribe(C0, p1.jpoints[j], p1.jpoints[k]);
+      if(h[LDIM] < 0) continue;
+      if(!clockwise(t, h)) continue;
+      if(best_k == -1)
+        best_k = k, best_h = h;
+      else if(clockwise(h, best_h))
+        best_k = k, best_h = h;
+      }
+    /* unbounded cell -- leave it empty, so that it is removed as a bad cell */
+    if(best_k == -1) { p1.vertices.clear(); p1.neid.clear(); return; }
+    p1.vertices.push_back(best_h);
+    p1.neid.push_back(p1.jindex[best_k]);
+    oldj = j, j = best_k, t = best_h;
+    if(isize(p1.vertices) == 15) break;
+    }
+  while(j != j0);
   }
     
 void bitruncate() {
@@ -173,23 +245,25 @@ void bitruncate() {
   }
 
 int rearrange(bool total, ld minedge) {
-  int tooshort = 0;
-  for(int i=0; i<isize(cells); i++) {
-    auto& p1 = cells[i];
-    hyperpoint h = Hypc;
-    for(auto v: p1.vertices) h = h + v;
-    
-    bool changed = total;
-
-    for(int j=0; j<isize(p1.vertices); j++)
-      if(hdist(p1.vertices[j], p1.vertices[(j+1) % isize(p1.vertices)]) < minedge) {
-        tooshort++; changed = true;
-        h = h + p1.vertices[j] + p1.vertices[(j+1) % isize(p1.vertices)];
-        }
-    if(changed)
-      cells[i].p = p1.pusher * normalize(h);
-    }
-  return tooshort;
+  return run_parallel(isize(cells), [&] (int a, int b) {
+    int tooshort = 0;
+    for(int i=a; i<b; i++) {
+      auto& p1 = cells[i];
+      hyperpoint h = Hypc;
+      for(auto v: p1.vertices) h = h + v;
+
+      bool changed = total;
+
+      for(int j=0; j<isize(p1.vertices); j++)
+        if(hdist(p1.vertices[j], p1.vertices[(j+1) % isize(p1.vertices)]) < minedge) {
+          tooshort++; changed = true;
+          h = h + p1.vertices[j] + p1.vertices[(j+1) % isize(p1.vertices)];
+          }
+      if(changed)
+        cells[i].p = p1.pusher * normalize(h);
+      }
+    return tooshort;
+    });
   }
 
 bool step(int delta) {
@@ -223,6 +297,7 @@ bool step(int delta) {
       }
      
     case 1: {
+      make_cells_of_heptagon();
       while(isize(cells) < cellcount) {
         if(SDL_GetTicks() > t + 250) { make_cells_of_heptagon(); status[0] = its(isize(cells)) + " cells"; return false; }
         cells.emplace_back();
@@ -234,15 +309,21 @@ bool step(int delta) {
           cell *c = all[k];
           map<cell*, transmatrix> relmatrices;
           hyperpoint h = randomPointIn(c->type);
-          for(auto c0: all) relmatrices[c0] = calc_relative_matrix(c0, c, h);
+          for(auto c0: base_vicinity(c)) relmatrices[c0] = calc_relative_matrix(c0, c, h);
           ld mindist = 1e6;
-          for(auto p: cells) {
-            if(!relmatrices.count(p.owner)) continue;
-            ld val = hdist(h, relmatrices[p.owner] * p.p);
-            if(val < mindist) mindist = val;
+          for(auto& rm: relmatrices) {
+            auto it = cells_of_heptagon.find(rm.first->master);
+            if(it == cells_of_heptagon.end()) continue;
+            for(int i: it->second) {
+              ld val = hdist(h, rm.second * cells[i].p);
+              if(val < mindist) mindist = val;
+              }
             }
           if(mindist > bestval) bestval = mindist, s.owner = c, s.p = h, s.relmatrices = std::move(relmatrices);
           }
+        auto& vc = cells_of_heptagon[s.owner->master];
+        s.localindex = isize(vc);
+        vc.push_back(isize(cells)-1);
         }
       make_cells_of_heptagon();
       cell_sorting = true; bitruncations_performed = 0;
@@ -264,49 +345,19 @@ bool step(int delta) {
       for(int k=0; k<16; k++) stats[k] = 0;
       
       compute_jpoints();
-      
-      for(int i=0; i<isize(cells); i++) {
-        auto &p1 = cells[i];
-    
-        p1.vertices.clear();
-        p1.neid.clear();
-    
-        int j = 0;
-        if(j == i) j = 1;
-    
-        for(int k=0; k<isize(cells); k++) if(k != i) {
-          if(hdist(p1.jpoints[k], C0) < hdist(p1.jpoints[j], C0))
-            j = k;
-          }
-          
-        hyperpoint t = mid(p1.jpoints[j], C0);
-              // p1.vertices.push_back(p1.pusher * t);
-        int j0 = j;
-        int oldj = j;
-        do {
-          int best_k = -1;
-          hyperpoint best_h;
-          for(int k=0; k<isize(cells); k++) if(k != i && k != j && k != oldj) {
-            hyperpoint h = circumscribe(C0, p1.jpoints[j], p1.jpoints[k]);
-            if(h[LDIM] < 0) continue;
-            if(!clockwise(t, h)) continue;
-            if(best_k == -1)
-              best_k = k, best_h = h;
-            else if(clockwise(h, best_h))
-              best_k = k, best_h = h;
-            }
-          p1.vertices.push_back(best_h);
-          p1.neid.push_back(best_k);
-          distlens.push_back(hdist0(best_h));
-          oldj = j, j = best_k, t = best_h;
-          if(j == -1) break;
-          if(isize(p1.vertices) == 15) break;
-          }
-        while(j != j0);
-        
+
+      run_parallel(isize(cells), [] (int a, int b) {
+        for(int i=a; i<b; i++) compute_voronoi_cell(i);
+        return 0;
+        });
+
+      for(auto& p1: cells) {
+        for(auto& v: p1.vertices)
+          distlens.push_back(hdist0(v));
+
         for(int j=0; j<isize(p1.vertices); j++)
           edgelens.push_back(hdist(p1.vertices[j], p1.vertices[(j+1) % isize(p1.vertices)]));
-    
+
         stats[isize(p1.vertices)]++;
         }
     
@@ -865,8 +916,8 @@ bool load_map(const string &fname) {
       double a, b, c;
       scan(f, a, b, c);
       s.p = hpxyz(a, b, c);
-      for(auto c0: all) s.relmatrices[c0] = calc_relative_matrix(c0, h, s.p);
       s.owner = h;
+      set_relmatrices(s);
       }
     }
 
@@ -905,8 +956,8 @@ EX void load_map_bin(hstream& f) {
       float_order.push_back(c);
       s.p = hpxyz(a, b, c);
       s.p = normalize(s.p);
-      for(auto c0: all) s.relmatrices[c0] = calc_relative_matrix(c0, h, s.p);
       s.owner = h;
+      set_relmatrices(s);
       }
     }
 
@@ -1057,6 +1108,7 @@ EX void init() {
   start_game();
   if(base) delete base;
   base = currentmap; 
+  vicinity.clear();
   base_config = euc::eu;
   cellcount = int(isize(base->allcells()) * density + .5);
   gridmaking = true;
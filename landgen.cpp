@@ -2999,6 +2999,66 @@ EX void set_land_for_geometry(cell *c) {
 
 EX hookset<bool(cell *c, int d, cell *from)> hooks_cellgen;
 
+#if HDR
+/** time spent and the number of calls of giantLandSwitch, see landgen_profiling */
+struct landgen_stat {
+  ld seconds;
+  int calls;
+  };
+#endif
+
+/** if true, the processor time of giantLandSwitch is attributed to the land of the cell and the setdist level, in landgen_profile */
+EX bool landgen_profiling = false;
+
+EX map<pair<eLand, int>, landgen_stat> landgen_profile;
+
+void profiled_land_switch(cell *c, int d, cell *from) {
+  if(!landgen_profiling) return giantLandSwitch(c, d, from);
+  eLand l = c->land;
+  clock_t t = clock();
+  giantLandSwitch(c, d, from);
+  auto& s = landgen_profile[{l, d}];
+  s.seconds += (clock() - t) * 1. / CLOCKS_PER_SEC;
+  s.calls++;
+  }
+
+/** print the limit most expensive (land, level) pairs from landgen_profile */
+EX void print_landgen_profile(int limit) {
+  vector<pair<pair<eLand, int>, landgen_stat>> v(landgen_profile.begin(), landgen_profile.end());
+  sort(v.begin(), v.end(), [] (const pair<pair<eLand, int>, landgen_stat>& a, const pair<pair<eLand, int>, landgen_stat>& b) { return a.second.seconds > b.second.seconds; });
+  ld total = 0;
+  for(auto& p: v) total += p.second.seconds;
+  println(hlog, "landgen total: ", int(total * 1000), " ms");
+  for(int i=0; i<isize(v) && i<limit; i++) {
+    auto& s = v[i].second;
+    println(hlog, lalign(24, dnameof(v[i].first.first)), " level ", lalign(3, v[i].first.second), " calls: ", lalign(8, s.calls),
+      " ms: ", lalign(8, int(s.seconds * 1000)), " us/call: ", s.seconds * 1e6 / s.calls);
+    }
+  }
+
+/** bring all the cells to setdist level d, level by level: every cell reaches a level before any of them proceeds to the next one,
+ *  and the cells of the same land are processed together; cells are expected to be listed in the order of the distance from the generated area,
+ *  e.g., by a celllister, so that each cell gets its land (at BARLEV) from a closer cell which has already been processed at BARLEV-1 */
+EX void setdist_bulk(const vector<cell*>& cells, int d) {
+  vector<cell*> todo;
+  for(int lev = BARLEV-1; lev >= d; lev--) {
+    todo.clear();
+    for(cell *c: cells) if(c->mpdist > lev) todo.push_back(c);
+    /* at BARLEV-1 the order matters, since the lands are still being set */
+    if(lev < BARLEV-1) stable_sort(todo.begin(), todo.end(), [] (cell *a, cell *b) { return a->land < b->land; });
+    for(cell *c: todo) {
+      /* in case if the order is not as expected */
+      cell *from = nullptr;
+      for(int i=0; i<c->type; i++) {
+        cell *c2 = c->move(i);
+        if(c2 && c2->mpdist < (from ? from->mpdist : c->mpdist)) from = c2;
+        }
+      setdist(c, lev, from);
+      if(buggyGeneration) return;
+      }
+    }
+  }
+
 EX void setdist(cell *c, int d, cell *from) {
 
   if(c == &out_of_bounds) return;
@@ -3142,11 +3202,11 @@ EX void setdist(cell *c, int d, cell *from) {
   if(!c->monst) c->stuntime = 0;
 
   bool big_first = ls::hv_structure();
-  if(!big_first) giantLandSwitch(c, d, from);
+  if(!big_first) profiled_land_switch(c, d, from);
   
   if(d == min(reduced_barlev, 9)) moreBigStuff(c);
 
-  if(big_first) giantLandSwitch(c, d, from);
+  if(big_first) profiled_land_switch(c, d, from);
 
   if(d == 7) repairLandgen(c);
   
@@ -264,10 +264,10 @@ void parrep(string& x, string w, stringpar p) {
     rep(x, "%abl"+w, data.abl);
     }
   if(l == 2) {
-    rep(x, "%"+w, N->n[1].nom);
-    rep(x, "%P"+w, N->n[1].nomp);
-    rep(x, "%a"+w, N->n[1].acc);
-    rep(x, "%abl"+w, N->n[1].abl);
+    rep(x, "%"+w, data.nom);
+    rep(x, "%P"+w, data.nomp);
+    rep(x, "%a"+w, data.acc);
+    rep(x, "%abl"+w, data.abl);
     }
   if(l == 3) {
     rep(x, "%"+w, data.nom);
@@ -343,51 +343,91 @@ void parrep(string& x, string w, stringpar p) {
 void postrep(string& s) {
   }
 
+/** how many XLAT results to remember; 0 to disable */
+EX int xlat_memo_size = 4096;
+
+/** XLAT results, for the language and genders in state; the key is the string followed by its parameters, separated by zero characters */
+struct xlat_memo_t {
+  std::unordered_map<string, string> results;
+  tuple<int, int, int> state = make_tuple(-1, -1, -1);
+  };
+
+/** XLAT is already used in static initializers, so this is created on first use */
+xlat_memo_t& get_xlat_memo() {
+  static xlat_memo_t memo;
+  return memo;
+  }
+
+template<class T> string xlat_memoized(const string& key, const T& compute) {
+  if(xlat_memo_size <= 0) return compute();
+  auto& xlat_memo = get_xlat_memo().results;
+  auto& xlat_memo_state = get_xlat_memo().state;
+  auto state = make_tuple(lang(), playergender(), princessgender());
+  if(state != xlat_memo_state) xlat_memo.clear(), xlat_memo_state = state;
+  auto it = xlat_memo.find(key);
+  if(it != xlat_memo.end()) return it->second;
+  /* strings with numbers in them would make it grow indefinitely */
+  if(isize(xlat_memo) >= xlat_memo_size) xlat_memo.clear();
+  return xlat_memo[key] = compute();
+  }
+
 /** translate the string @x */
 EX string XLAT(string x) { 
-  basicrep(x);
-  postrep(x);
-  return x;
+  return xlat_memoized(x, [&] {
+    basicrep(x);
+    postrep(x);
+    return x;
+    });
   }
 EX string XLAT(string x, stringpar p1) { 
-  basicrep(x);
-  parrep(x,"1",p1.v);
-  postrep(x);
-  return x;
+  return xlat_memoized(x + '\0' + p1.v, [&] {
+    basicrep(x);
+    parrep(x,"1",p1.v);
+    postrep(x);
+    return x;
+    });
   }
 EX string XLAT(string x, stringpar p1, stringpar p2) { 
-  basicrep(x);
-  parrep(x,"1",p1.v);
-  parrep(x,"2",p2.v);
-  postrep(x);
-  return x;
+  return xlat_memoized(x + '\0' + p1.v + '\0' + p2.v, [&] {
+    basicrep(x);
+    parrep(x,"1",p1.v);
+    parrep(x,"2",p2.v);
+    postrep(x);
+    return x;
+    });
   }
 EX string XLAT(string x, stringpar p1, stringpar p2, stringpar p3) { 
-  basicrep(x);
-  parrep(x,"1",p1.v);
-  parrep(x,"2",p2.v);
-  parrep(x,"3",p3.v);
-  postrep(x);
-  return x;
+  return xlat_memoized(x + '\0' + p1.v + '\0' + p2.v + '\0' + p3.v, [&] {
+    basicrep(x);
+    parrep(x,"1",p1.v);
+    parrep(x,"2",p2.v);
+    parrep(x,"3",p3.v);
+    postrep(x);
+    return x;
+    });
   }
 EX string XLAT(string x, stringpar p1, stringpar p2, stringpar p3, stringpar p4) { 
-  basicrep(x);
-  parrep(x,"1",p1.v);
-  parrep(x,"2",p2.v);
-  parrep(x,"3",p3.v);
-  parrep(x,"4",p4.v);
-  postrep(x);
-  return x;
+  return xlat_memoized(x + '\0' + p1.v + '\0' + p2.v + '\0' + p3.v + '\0' + p4.v, [&] {
+    basicrep(x);
+    parrep(x,"1",p1.v);
+    parrep(x,"2",p2.v);
+    parrep(x,"3",p3.v);
+    parrep(x,"4",p4.v);
+    postrep(x);
+    return x;
+    });
   }
 EX string XLAT(string x, stringpar p1, stringpar p2, stringpar p3, stringpar p4, stringpar p5) { 
-  basicrep(x);
-  parrep(x,"1",p1.v);
-  parrep(x,"2",p2.v);
-  parrep(x,"3",p3.v);
-  parrep(x,"4",p4.v);
-  parrep(x,"5",p5.v);
-  postrep(x);
-  return x;
+  return xlat_memoized(x + '\0' + p1.v + '\0' + p2.v + '\0' + p3.v + '\0' + p4.v + '\0' + p5.v, [&] {
+    basicrep(x);
+    parrep(x,"1",p1.v);
+    parrep(x,"2",p2.v);
+    parrep(x,"3",p3.v);
+    parrep(x,"4",p4.v);
+    parrep(x,"5",p5.v);
+    postrep(x);
+    return x;
+    });
   }
 
 
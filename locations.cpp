@@ -393,6 +393,7 @@ typedef walker<cell> cellwalker;
   * Only one celllister may be active at a time, using the stack semantics.
   * Only the most recently created one works; the previous one will resume 
   * working when this one is destroyed.
+  * See hashed_manual_celllister for a version without this restriction.
   */
 struct manual_celllister {
   /** \brief list of cells in this list */
@@ -413,17 +414,63 @@ struct manual_celllister {
     return true;
     }
 
+  /** \brief the position of a listed cell in lst */
+  int index_of(cell *c) { return c->listindex; }
+
   ~manual_celllister() {     
     for(int i=0; i<isize(lst); i++) lst[i]->listindex = tmps[i];
     }  
   };
+
+/** \brief A manual_celllister which does not use cell::listindex.
+  *
+  * The listed cells are found in its own hash table instead, so any number of these
+  * may be active at once, and they may be used in worker threads (as long as no
+  * thread creates cells). Slower than manual_celllister, since each lookup goes through the table.
+  */
+struct hashed_manual_celllister {
+  /** \brief list of cells in this list */
+  vector<cell*> lst;
+  /** positions in lst, by the hash of the cell; -1 if empty */
+  vector<int> table;
+  int bits;
+
+  hashed_manual_celllister() { bits = 4; table.resize(1<<bits, -1); }
+
+  int find_slot(cell *c) {
+    int mask = (1<<bits) - 1;
+    int i = int((uint64_t(size_t(c)) * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+    while(table[i] >= 0 && lst[table[i]] != c) i = (i+1) & mask;
+    return i;
+    }
+
+  /** \brief is the given cell on the list? */
+  bool listed(cell *c) { return table[find_slot(c)] >= 0; }
+
+  /** \brief the position of a listed cell in lst */
+  int index_of(cell *c) { return table[find_slot(c)]; }
+
+  /** \brief add a cell to the list */
+  bool add(cell *c) {
+    if(2 * (isize(lst) + 1) > isize(table)) {
+      bits++;
+      table.assign(1<<bits, -1);
+      for(int k=0; k<isize(lst); k++) table[find_slot(lst[k])] = k;
+      }
+    int i = find_slot(c);
+    if(table[i] >= 0) return false;
+    table[i] = isize(lst);
+    lst.push_back(c);
+    return true;
+    }
+  };
   
-/** \brief automatically generate a list of nearby cells */
-struct celllister : manual_celllister {
+/** \brief automatically generate a list of nearby cells, using the given manual celllister */
+template<class M> struct basic_celllister : M {
   vector<int> dists;
   
   void add_at(cell *c, int d) {
-    if(add(c)) dists.push_back(d);
+    if(this->add(c)) dists.push_back(d);
     }
   
   /** \brief automatically generate a list of nearby cells
@@ -432,7 +479,8 @@ struct celllister : manual_celllister {
   @param maxcount maximum number of cells to cover
   @param breakon we are actually looking for this cell, so stop when reaching it
   */
-  celllister(cell *orig, int maxdist, int maxcount, cell *breakon) {
+  basic_celllister(cell *orig, int maxdist, int maxcount, cell *breakon) {
+    auto& lst = this->lst;
     add_at(orig, 0);
     cell *last = orig;
     for(int i=0; i<isize(lst); i++) {
@@ -449,7 +497,17 @@ struct celllister : manual_celllister {
     }
   
   /** \brief for a given cell c on the list, return its distance from orig */
-  int getdist(cell *c) { return dists[c->listindex]; }
+  int getdist(cell *c) { return dists[this->index_of(c)]; }
+  };
+
+/** \brief automatically generate a list of nearby cells */
+struct celllister : basic_celllister<manual_celllister> {
+  using basic_celllister<manual_celllister>::basic_celllister;
+  };
+
+/** \brief like celllister, but based on hashed_manual_celllister, so it may be nested freely and used in worker threads (note that it creates the cells it visits) */
+struct hashed_celllister : basic_celllister<hashed_manual_celllister> {
+  using basic_celllister<hashed_manual_celllister>::basic_celllister;
   };
 
 /** \brief translate heptspins to cellwalkers and vice versa */
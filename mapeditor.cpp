@@ -441,6 +441,15 @@ EX namespace mapstream {
   EX std::map<cell*, int> cellids;
   EX vector<cell*> cellbyid;
   EX vector<char> relspin;
+
+  /** in the chunked format, the cells are saved in blocks of this size, compressed separately, and decoded in parallel */
+  EX int chunk_size = 65536;
+  /** save maps in the chunked format (not readable by HyperRogue versions before it was introduced) */
+  EX bool save_chunked = false;
+  /** this bit is set in the version number of the maps saved in the chunked format */
+  static constexpr color_t CHUNKED_FORMAT = 0x80000000;
+  /** is the map currently saved/loaded in the chunked format */
+  bool chunked_now = false;
   
   void load_drawing_tool(hstream& hs) {
     using namespace mapeditor;
@@ -747,6 +756,100 @@ EX namespace mapstream {
     }
 
 #if CAP_EDIT  
+  /** write the link of the i-th saved cell to an earlier cell */
+  void save_parent_link(hstream& f, int i) {
+    cell *c = cellbyid[i];
+    for(int j=0; j<c->type; j++) if(c->move(j) && cellids.count(c->move(j)) && 
+      cellids[c->move(j)] < i) {
+      int32_t i = cellids[c->move(j)];
+      f.write(i);
+      f.write_char(c->c.spin(j));
+      f.write_char(j);
+      return;
+      }
+    println(hlog, "parent not found for ", c, "!");
+    for(int j=0; j<c->type; j++) println(hlog, j, ": ", c->move(j), "; ", int(cellids.count(c->move(j)) ? cellids[c->move(j)] : -1));
+    throw hr_exception("parent not found");
+    }
+
+  void save_cell_contents(hstream& f, cell *c) {
+    f.write_char(c->land);
+    f.write_char(c->mondir);
+    f.write_char(c->monst);
+    if(c->monst == moTortoise)
+      f.write(tortoise::emap[c] = tortoise::getb(c));
+    f.write_char(c->wall);
+    if(dice::on(c)) {
+      auto& dat = dice::data[c];
+      f.write_char(dice::get_die_id(dat.which));
+      f.write_char(dat.val);
+      f.write_char(dat.dir);
+      f.write_char(dat.mirrored);
+      }
+    f.write_char(c->item);
+    if(c->item == itBabyTortoise)
+      f.write(tortoise::babymap[c]);
+    f.write_char(c->mpdist);
+    if(inmirrororwall(c)) {
+      f.write_char(c->barleft);
+      f.write_char(c->barright);
+      f.write_char(c->bardir);
+      }
+    f.write(c->wparam); f.write(c->landparam);
+    f.write_char(c->stuntime); f.write_char(c->hitpoints);
+    }
+
+  void add_neighbors_to_queue(cell *c) {
+    #if CAP_PORTALS
+    if(intra::in && isWall3(c) && !intra::need_to_save.count(c)) return;
+    #endif
+    for(int j=0; j<c->type; j++) {
+      cell *c2 = c->move(j);
+      if(c2 && c2->land != laNone && c2->land != laMemory) addToQueue(c2);
+      }
+    }
+
+  /** save the cells in the chunked format; the cell records are encoded sequentially, since that also lists the cells, but compressed in parallel */
+  void save_cells_chunked(hstream& f) {
+    vector<shstream> blocks(1);
+    for(auto& b: blocks) b.vernum = f.vernum;
+    for(int i=0; i<isize(cellbyid); i++) {
+      if(i) save_parent_link(blocks[0], i);
+      if(i % chunk_size == 0) { blocks.emplace_back(); blocks.back().vernum = f.vernum; }
+      save_cell_contents(blocks.back(), cellbyid[i]);
+      add_neighbors_to_queue(cellbyid[i]);
+      }
+    int nblocks = isize(blocks);
+    vector<string> stored(nblocks);
+    char compressed = false;
+    #if CAP_ZLIB
+    /* fast compression: the maps are very repetitive anyway */
+    compressed = !run_parallel(nblocks, [&] (int a, int b) {
+      int fails = 0;
+      for(int k=a; k<b; k++) {
+        auto& s = blocks[k].s;
+        uLongf len = compressBound(s.size());
+        stored[k].resize(len);
+        if(compress2((Bytef*) &stored[k][0], &len, (const Bytef*) s.data(), s.size(), Z_BEST_SPEED) != Z_OK) fails++;
+        stored[k].resize(len);
+        }
+      return fails;
+      });
+    #endif
+    if(!compressed) for(int k=0; k<nblocks; k++) stored[k] = blocks[k].s;
+    int n = isize(cellbyid);
+    f.write(n);
+    f.write(chunk_size);
+    f.write(compressed);
+    f.write(nblocks);
+    for(int k=0; k<nblocks; k++) {
+      int raw = isize(blocks[k].s), st = isize(stored[k]);
+      f.write(raw); f.write(st);
+      }
+    for(auto& s: stored) f.write_chars(s.data(), s.size());
+    printf("cells saved = %d in %d blocks\n", n, nblocks - 1);
+    }
+
   void save_only_map(hstream& f) {
     f.write(patterns::whichPattern);
     save_geometry(f);
@@ -784,61 +887,16 @@ EX namespace mapstream {
     #if CAP_PORTALS
     if(intra::in) intra::prepare_need_to_save();
     #endif
-    for(int i=0; i<isize(cellbyid); i++) {
-      cell *c = cellbyid[i];
-      if(i) {
-        bool ok = false;
-        for(int j=0; j<c->type; j++) if(c->move(j) && cellids.count(c->move(j)) && 
-          cellids[c->move(j)] < i) {
-          int32_t i = cellids[c->move(j)];
-          f.write(i);
-          f.write_char(c->c.spin(j));
-          f.write_char(j);
-          ok = true;
-          break;
-          }
-        if(!ok) {
-          println(hlog, "parent not found for ", c, "!");
-          for(int j=0; j<c->type; j++) println(hlog, j, ": ", c->move(j), "; ", int(cellids.count(c->move(j)) ? cellids[c->move(j)] : -1));
-          throw hr_exception("parent not found");
-          }
-        }
-      f.write_char(c->land);
-      f.write_char(c->mondir);
-      f.write_char(c->monst);
-      if(c->monst == moTortoise)
-        f.write(tortoise::emap[c] = tortoise::getb(c));
-      f.write_char(c->wall);
-      if(dice::on(c)) {
-        auto& dat = dice::data[c];
-        f.write_char(dice::get_die_id(dat.which));
-        f.write_char(dat.val);
-        f.write_char(dat.dir);
-        f.write_char(dat.mirrored);
-        }
-      f.write_char(c->item);
-      if(c->item == itBabyTortoise)
-        f.write(tortoise::babymap[c]);
-      f.write_char(c->mpdist);
-      if(inmirrororwall(c)) {
-        f.write_char(c->barleft);
-        f.write_char(c->barright);
-        f.write_char(c->bardir);
-        }
-      f.write(c->wparam); f.write(c->landparam);
-      f.write_char(c->stuntime); f.write_char(c->hitpoints);
-      bool blocked = false;
-      #if CAP_PORTALS
-      if(intra::in && isWall3(c) && !intra::need_to_save.count(c)) blocked = true;
-      #endif
-      if(!blocked)
-      for(int j=0; j<c->type; j++) {
-        cell *c2 = c->move(j);
-        if(c2 && c2->land != laNone && c2->land != laMemory) addToQueue(c2);
+    if(chunked_now) save_cells_chunked(f);
+    else {
+      for(int i=0; i<isize(cellbyid); i++) {
+        if(i) save_parent_link(f, i);
+        save_cell_contents(f, cellbyid[i]);
+        add_neighbors_to_queue(cellbyid[i]);
         }
+      printf("cells saved = %d\n", isize(cellbyid));
+      int32_t n = -1; f.write(n);
       }
-    printf("cells saved = %d\n", isize(cellbyid));
-    int32_t n = -1; f.write(n);
     int32_t id = cellids.count(cwt.at) ? cellids[cwt.at] : -1;
     f.write(id);
 
@@ -934,6 +992,140 @@ EX namespace mapstream {
       }    
     }
   
+  /** read the link of a loaded cell to its parent, already read, and create it */
+  cell *load_parent_link(hstream& f, int parent, int sub, int& rspin) {
+    int dir = f.read_char();
+    cell *c2 = cellbyid[parent];
+    dir = fixspin(relspin[parent], dir, c2->type - sub, f.vernum);
+    cell *c = createMov(c2, dir);
+    // printf("%p:%d,%d -> %p\n", c2, relspin[parent], dir, c);
+    
+    // spinval becomes xspinval
+    rspin = gmod(c2->c.spin(dir) - f.read_char(), c->type - sub);
+    if(GDIM == 3 && rspin && !mhybrid) {
+      println(hlog, "rspin in 3D");
+      throw hstream_exception();
+      }
+    return c;
+    }
+
+  /** read the contents of c; this touches only c itself, so it may run in parallel for distinct cells, the changes to global maps are put into deferred */
+  void load_cell_contents(hstream& f, cell *c, int rspin, int sub, vector<reaction_t>& deferred) {
+    c->land = (eLand) f.read_char();
+    c->mondir = fixspin(rspin, f.read_char(), c->type - sub, f.vernum);
+    c->monst = (eMonster) f.read_char();
+    if(c->monst == moTortoise && f.vernum >= 11001) {
+      int emap = f.get<int>();
+      deferred.push_back([c, emap] { tortoise::emap[c] = emap; });
+      }
+    c->wall = (eWall) f.read_char();
+    if(dice::on(c)) {
+      dice::die_data dat;
+      dat.which = dice::get_by_id(f.read_char());
+      dat.val = f.read_char();
+      dat.dir = fixspin(rspin, f.read_char(), c->type, f.vernum);
+      dat.mirrored = false;
+      if(f.vernum >= 0xA902)
+        dat.mirrored = f.read_char();
+      deferred.push_back([c, dat] { dice::data[c] = dat; });
+      }
+    // c->barleft = (eLand) f.read_char();
+    // c->barright = (eLand) f.read_char();
+    c->item = (eItem) f.read_char();
+    if(c->item == itBabyTortoise && f.vernum >= 11001) {
+      int baby = f.get<int>();
+      deferred.push_back([c, baby] { tortoise::babymap[c] = baby; });
+      }
+    c->mpdist = f.read_char();
+    c->bardir = NOBARRIERS;
+    if(inmirrororwall(c) && f.vernum >= 0xA912) {
+      c->barleft = (eLand) f.read_char();
+      c->barright = (eLand) f.read_char();
+      c->bardir = fixspin(rspin, f.read_char(), c->type, f.vernum);
+      }
+    // fixspin(rspin, f.read_char(), c->type);
+    if(f.vernum < 7400) {
+      short z;
+      f.read(z);
+      c->wparam = z;
+      }
+    else f.read(c->wparam);
+    f.read(c->landparam);
+    // backward compatibility
+    if(f.vernum < 7400 && !isIcyLand(c->land)) c->landparam = HEAT(c);
+    c->stuntime = f.read_char();
+    c->hitpoints = f.read_char();
+    }
+
+  /** the blocks of the chunked format; block 0 lists the parent links, and each further block lists the contents of chunk_size consecutive cells */
+  string unpack_block(const string& data, int raw, char compressed) {
+    if(!compressed) {
+      if(isize(data) != raw) throw hstream_exception();
+      return data;
+      }
+    #if CAP_ZLIB
+    string s(raw, 0);
+    uLongf len = raw;
+    if(raw && uncompress((Bytef*) &s[0], &len, (const Bytef*) data.data(), data.size()) != Z_OK) throw hstream_exception();
+    if(int(len) != raw) throw hstream_exception();
+    return s;
+    #else
+    throw hstream_exception();
+    #endif
+    }
+
+  void load_cells_chunked(hstream& f, int sub) {
+    int n = f.get<int>();
+    int bs = f.get<int>();
+    char compressed = f.read_char();
+    int nblocks = f.get<int>();
+    if(n < 1 || bs < 1 || nblocks != 1 + (n - 1) / bs + 1) throw hstream_exception();
+    vector<int> raw(nblocks), stored(nblocks);
+    for(int k=0; k<nblocks; k++) {
+      f.read(raw[k]); f.read(stored[k]);
+      if(raw[k] < 0 || stored[k] < 0) throw hstream_exception();
+      }
+    vector<string> data(nblocks);
+    for(int k=0; k<nblocks; k++) {
+      data[k].resize(stored[k]);
+      if(stored[k]) f.read_chars(&data[k][0], stored[k]);
+      }
+
+    shstream skeleton(unpack_block(data[0], raw[0], compressed));
+    skeleton.vernum = f.vernum;
+    cellbyid.reserve(n);
+    relspin.reserve(n);
+    cellbyid.push_back(currentmap->gamestart());
+    relspin.push_back(0);
+    for(int i=1; i<n; i++) {
+      int32_t parent = skeleton.get<int>();
+      if(parent < 0 || parent >= i) throw hstream_exception();
+      int rspin;
+      cellbyid.push_back(load_parent_link(skeleton, parent, sub, rspin));
+      relspin.push_back(rspin);
+      }
+
+    vector<vector<reaction_t>> deferred(nblocks);
+    int failed = run_parallel(nblocks - 1, [&] (int a, int b) {
+      int fails = 0;
+      for(int k=a; k<b; k++) try {
+        shstream ss(unpack_block(data[k+1], raw[k+1], compressed));
+        ss.vernum = f.vernum;
+        for(int i=k*bs; i<min(n, (k+1)*bs); i++)
+          load_cell_contents(ss, cellbyid[i], relspin[i], sub, deferred[k]);
+        if(ss.pos != isize(ss.s)) fails++;
+        }
+      catch(hstream_exception&) { fails++; }
+      return fails;
+      });
+    if(failed) throw hstream_exception();
+    for(auto& d: deferred) for(auto& r: d) r();
+
+    if(patterns::whichPattern)
+      for(cell *c: cellbyid)
+        mapeditor::modelcell[patterns::getpatterninfo0(c).id] = c;
+    }
+
   void load_only_map(hstream& f) {
     stop_game();
     if(f.vernum >= 10420 && f.vernum < 10503) {
@@ -990,7 +1182,8 @@ EX namespace mapstream {
       }
 
     int sub = mhybrid ? 2 : 0;
-    while(true) {
+    if(chunked_now) load_cells_chunked(f, sub);
+    else while(true) {
       cell *c;
       int rspin;
       
@@ -1002,60 +1195,14 @@ EX namespace mapstream {
         int32_t parent = f.get<int>();
         
         if(parent<0 || parent >= isize(cellbyid)) break;
-        int dir = f.read_char();
-        cell *c2 = cellbyid[parent];
-        dir = fixspin(relspin[parent], dir, c2->type - sub, f.vernum);
-        c = createMov(c2, dir);
-        // printf("%p:%d,%d -> %p\n", c2, relspin[parent], dir, c);
-        
-        // spinval becomes xspinval
-        rspin = gmod(c2->c.spin(dir) - f.read_char(), c->type - sub);
-        if(GDIM == 3 && rspin && !mhybrid) {
-          println(hlog, "rspin in 3D");
-          throw hstream_exception();
-          }
+        c = load_parent_link(f, parent, sub, rspin);
         }
       
       cellbyid.push_back(c);
       relspin.push_back(rspin);
-      c->land = (eLand) f.read_char();
-      c->mondir = fixspin(rspin, f.read_char(), c->type - sub, f.vernum);
-      c->monst = (eMonster) f.read_char();
-      if(c->monst == moTortoise && f.vernum >= 11001)
-        f.read(tortoise::emap[c]);
-      c->wall = (eWall) f.read_char();
-      if(dice::on(c)) {
-        auto& dat = dice::data[c];        
-        dat.which = dice::get_by_id(f.read_char());
-        dat.val = f.read_char();
-        dat.dir = fixspin(rspin, f.read_char(), c->type, f.vernum);
-        if(f.vernum >= 0xA902)
-          dat.mirrored = f.read_char();
-        }
-      // c->barleft = (eLand) f.read_char();
-      // c->barright = (eLand) f.read_char();
-      c->item = (eItem) f.read_char();
-      if(c->item == itBabyTortoise && f.vernum >= 11001)
-        f.read(tortoise::babymap[c]);
-      c->mpdist = f.read_char();
-      c->bardir = NOBARRIERS;
-      if(inmirrororwall(c) && f.vernum >= 0xA912) {
-        c->barleft = (eLand) f.read_char();
-        c->barright = (eLand) f.read_char();
-        c->bardir = fixspin(rspin, f.read_char(), c->type, f.vernum);
-        }
-      // fixspin(rspin, f.read_char(), c->type);
-      if(f.vernum < 7400) {
-        short z;
-        f.read(z);
-        c->wparam = z;
-        }
-      else f.read(c->wparam);
-      f.read(c->landparam);
-      // backward compatibility
-      if(f.vernum < 7400 && !isIcyLand(c->land)) c->landparam = HEAT(c);
-      c->stuntime = f.read_char();
-      c->hitpoints = f.read_char();
+      vector<reaction_t> deferred;
+      load_cell_contents(f, c, rspin, sub, deferred);
+      for(auto& r: deferred) r();
 
       if(patterns::whichPattern)
         mapeditor::modelcell[patterns::getpatterninfo0(c).id] = c;
@@ -1214,7 +1361,8 @@ EX namespace mapstream {
     }
 
   EX void saveMap(hstream& f) {
-    f.write(f.get_vernum());
+    chunked_now = save_chunked;
+    f.write(f.get_vernum() | (chunked_now ? CHUNKED_FORMAT : 0));
     f.write(dual::state);
     #if CAP_PORTALS
     int q = intra::in ? isize(intra::data) : 0;
@@ -1243,6 +1391,16 @@ EX namespace mapstream {
     save_usershapes(f);
     }
   
+  /** generate the map to the given radius around the player, level by level (setdist_bulk), and save it in the chunked format;
+   *  loading the result with -load gives a warm start, and the generation continues lazily beyond its boundary */
+  EX bool save_pregenerated(const string& fname, int radius) {
+    celllister cl(cwt.at, radius, 1000000000, NULL);
+    setdist_bulk(cl.lst, 7);
+    if(buggyGeneration) return false;
+    dynamicval<bool> dc(save_chunked, true);
+    return saveMap(fname.c_str());
+    }
+
   EX bool loadMap(const string& fname) {
     fhstream f(fname, "rb");
     if(!f.f) return false;
@@ -1251,6 +1409,8 @@ EX namespace mapstream {
     
   EX bool loadMap(hstream& f) {
     f.read(f.vernum);
+    chunked_now = f.vernum & CHUNKED_FORMAT;
+    f.vernum &= ~CHUNKED_FORMAT;
     if(f.vernum > 10505 && f.vernum < 11000) 
       f.vernum = 11005;
     auto ds = dual::state;
@@ -3409,6 +3569,17 @@ int read_editor_args() {
   else if(argis("-pic")) { shift(); picfile = args(); }
   else if(argis("-load")) { PHASE(3); shift(); mapstream::loadMap(args()); }
   else if(argis("-save")) { PHASE(3); shift(); mapstream::saveMap(args().c_str()); }
+  else if(argis("-pregen")) {
+    PHASEFROM(2); start_game();
+    shift(); int radius = argi();
+    shift(); string fname = args();
+    if(!mapstream::save_pregenerated(fname, radius)) println(hlog, "failed to pregenerate ", fname);
+    }
+  else if(argis("-save-chunked")) {
+    shift(); int bs = argi();
+    mapstream::save_chunked = bs > 0;
+    if(bs > 0) mapstream::chunk_size = bs;
+    }
   else if(argis("-d:draw")) { PHASE(3); 
     #if CAP_EDIT
     start_game();
@@ -1209,15 +1209,27 @@ void geometry_information::prepare_shapes() {
   // printf("crossf = %f euclid = %d sphere = %d\n", float(crossf), euclid, sphere);
   hpc.clear(); ext.clear();
 
+  /* timing log of the phases, as shape generation is a noticeable stall in 3D geometries */
+  int tstart = SDL_GetTicks(), tlast = tstart;
+  auto phase_done = [&] (const char *name) {
+    int t = SDL_GetTicks();
+    DEBB(DF_POLY, (name, ": ", t - tlast, " ms, ", isize(hpc), " vertices"));
+    tlast = t;
+    };
+
   make_sidewalls();
+  phase_done("sidewalls");
 
   procedural_shapes();
+  phase_done("procedural shapes");
 
   #if MAXMDIM >= 4
   create_wall3d();
+  phase_done("3D walls");
   #endif
 
   configure_floorshapes();
+  phase_done("floorshapes");
 
   // hand-drawn shapes
 
@@ -1684,14 +1696,19 @@ void geometry_information::prepare_shapes() {
   bshape(shBead1, PPR(20), 1, 251);
   bshape(shArrow, PPR::ARROW, 1, 252);
 
+  phase_done("hand-drawn shapes");
+
   #if MAXMDIM >= 4
   make_3d_models();
+  phase_done("3D models");
   #endif
 
   finishshape();
   prehpc = isize(hpc);
 
   initPolyForGL();
+  phase_done("GL buffer");
+  DEBB(DF_POLY, ("prepare_shapes total: ", tlast - tstart, " ms"));
   }
 
 EX vector<long double> polydata = {
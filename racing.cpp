@@ -73,6 +73,8 @@ struct ghost {
   int checksum;
   long long timestamp;
   vector<ghostmoment> history;
+  /** the position found by the last get_ghostmoment, to narrow down the search */
+  int cursor = 0;
   };
 
 vector<ghost> ghostset;
@@ -105,12 +107,70 @@ void hwrite(hstream& hs, const ghost& gh) {
   hwrite(hs, gh.cs, gh.result, gh.timestamp, gh.checksum, gh.history);
   }
 
+/** written instead of the number of ghosts to mark the compact format, where the steps and cell ids of the moments are delta-coded varints */
+static constexpr int GHOST_COMPACT = -1;
+
+void write_varint(hstream& hs, int x) {
+  unsigned u = (unsigned(x) << 1) ^ unsigned(x >> 31);
+  while(u >= 128) { hs.write_char(char(u | 128)); u >>= 7; }
+  hs.write_char(char(u));
+  }
+
+int read_varint(hstream& hs) {
+  unsigned u = 0;
+  for(int sh=0; sh<35; sh+=7) {
+    unsigned char c = hs.read_char();
+    u |= unsigned(c & 127) << sh;
+    if(!(c & 128)) return int(u >> 1) ^ -int(u & 1);
+    }
+  throw hstream_exception();
+  }
+
+void write_compact(hstream& hs, const ghost& gh) {
+  hwrite(hs, gh.cs, gh.result, gh.timestamp, gh.checksum);
+  hs.write<int>(isize(gh.history));
+  int step = 0, id = 0;
+  for(auto& m: gh.history) {
+    int nid = mapstream::cellids[m.where_cell];
+    write_varint(hs, m.step - step);
+    write_varint(hs, nid - id);
+    step = m.step; id = nid;
+    hwrite(hs, m.alpha, m.distance, m.beta, m.footphase);
+    }
+  }
+
+void read_compact(hstream& hs, ghost& gh) {
+  hread(hs, gh.cs, gh.result, gh.timestamp, gh.checksum);
+  int n = hs.get<int>();
+  if(n < 0) throw hstream_exception();
+  gh.history.resize(n);
+  int step = 0, id = 0;
+  for(auto& m: gh.history) {
+    m.step = step += read_varint(hs);
+    id += read_varint(hs);
+    if(id < 0 || id >= isize(mapstream::cellbyid)) throw hr_exception("error reading a ghost moment");
+    m.where_cell = mapstream::cellbyid[id];
+    hread(hs, m.alpha, m.distance, m.beta, m.footphase);
+    }
+  }
+
 EX void save_ghosts(hstream& f) {
-  hwrite(f, ghostset);
+  f.write<int>(GHOST_COMPACT);
+  f.write<int>(isize(ghostset));
+  for(auto& gh: ghostset) write_compact(f, gh);
   }
 
 EX void load_ghosts(hstream& f) {
-  hread(f, ghostset);
+  int n = f.get<int>();
+  if(n == GHOST_COMPACT) {
+    ghostset.resize(f.get<int>());
+    for(auto& gh: ghostset) read_compact(f, gh);
+    }
+  else {
+    if(n < 0) throw hstream_exception();
+    ghostset.resize(n);
+    for(auto& gh: ghostset) hread(f, gh);
+    }
   }
 
 #endif
@@ -194,32 +254,43 @@ int length;
 
 bool use_exhaustive_distance;
 
+/** the cells to expand in find_track, bucketed by their track value; bucket i holds the value lo+i, and the last bucket is expanded first */
+struct track_frontier {
+  int lo = 0;
+  vector<vector<cell*>> buckets;
+  void add(int id, cell *c) {
+    if(buckets.empty()) lo = id;
+    if(id < lo) { buckets.insert(buckets.begin(), lo - id, vector<cell*>()); lo = id; }
+    if(id - lo >= isize(buckets)) buckets.resize(id - lo + 1);
+    buckets[id - lo].push_back(c);
+    }
+  int top() { return lo + isize(buckets) - 1; }
+  };
+
 void find_track(cell *start, int sign, int len) {
   int dl = 7 - getDistLimit() - genrange_bonus;
   dl = (8 + dl) / 2;
   if(WDIM == 3 && dl < 6) dl = 6;
   cell *goal;
-  map<cell*, cell*> parent;
-  map<int, vector<cell*> > cellbydist;
-  cellbydist[0].push_back(start);
+  std::unordered_map<cell*, cell*> parent;
+  parent[start] = nullptr;
+  track_frontier cellbydist;
+  cellbydist.add(0, start);
     
   int traversed = 0;
   
   while(true) {
     traversed++;
-    if(cellbydist.empty()) {
+    if(cellbydist.buckets.empty()) {
       println(hlog, "reset after traversing ", traversed, " width = ", TWIDTH, " length = ", length);
       throw hr_track_failure();
       }
-    auto it = cellbydist.end();
-    it--;
-    // if(hrand(100) < 85 && it != cellbydist.begin()) it--;
-    auto& v = it->second;
-    if(v.empty()) { cellbydist.erase(it); continue; }
+    auto& v = cellbydist.buckets.back();
+    if(v.empty()) { cellbydist.buckets.pop_back(); continue; }
     int id = hrand(isize(v));
     cell *c = v[id];
     v[id] = v.back(); v.pop_back();    
-    if(it->first >= length) {
+    if(cellbydist.top() >= length) {
       goal = c;
       break;
       }
@@ -258,7 +329,7 @@ void find_track(cell *start, int sign, int len) {
       #endif
       else
         id = trackval(c1);
-      cellbydist[id].push_back(c1);
+      cellbydist.add(id, c1);
       }
     }
 
@@ -814,6 +885,13 @@ int readArgs() {
     PHASEFROM(2);
     load_official_track();
     }
+  #if CAP_EDIT
+  else if(argis("-racing-convert")) {
+    PHASEFROM(2);
+    shift(); string fname = args();
+    shift(); convert_official_tracks(fname, args());
+    }
+  #endif
   else if(argis("-rsc")) {
     standard_centering = true;
     }
@@ -903,6 +981,32 @@ EX string racetimeformat(int t) {
 
 extern int playercfg;
 
+#if CAP_EDIT
+/** rewrite the official tracks from fname to fname_out, so that their ghosts are stored in the compact format */
+EX void convert_official_tracks(const string& fname, const string& fname_out) {
+  fhstream f(fname, "rb");
+  if(!f.f) throw hstream_exception();
+  hread(f, f.vernum);
+  map<eLand, string> tracks;
+  hread(f, tracks);
+  for(auto& p: tracks) {
+    stop_game();
+    specialland = p.first;
+    if(!racing::on) switch_game_mode(rg::racing);
+    racing::on = false;
+    shstream sf(decompress_string(p.second));
+    mapstream::loadMap(sf);
+    shstream so;
+    mapstream::saveMap(so);
+    println(hlog, dnameof(p.first), ": ", isize(sf.s), " -> ", isize(so.s), " bytes");
+    p.second = compress_string(so.s);
+    }
+  fhstream fo(fname_out, "wb");
+  hwrite(fo, fo.vernum);
+  hwrite(fo, tracks);
+  }
+#endif
+
 EX void load_official_track() {
   fhstream f("officials.data", "rb");
   hread(f, f.vernum);
@@ -1336,15 +1440,28 @@ void draw_ghost_at(ghost& ghost, cell *w, const shiftmatrix& V, ghostmoment& p)
   drawMonsterType(moPlayer, w, V, 0, uchar_to_frac(p.footphase), NOCOLOR);
   }
 
+/** the index of the first moment of the ghost after the current time; the history is sorted by step, and the time usually moves forward a bit from the last call */
+int ghost_position(ghost& ghost) {
+  auto& h = ghost.history;
+  int t = ticks - race_start_tick;
+  int& at = ghost.cursor;
+  if(at > isize(h)) at = isize(h);
+  auto cmp = [] (int t, const ghostmoment& gm) { return t < gm.step; };
+  if(at == 0 || h[at-1].step <= t)
+    at = std::upper_bound(h.begin() + at, h.end(), t, cmp) - h.begin();
+  else
+    at = std::upper_bound(h.begin(), h.begin() + at, t, cmp) - h.begin();
+  return at;
+  }
+
 bool ghost_finished(ghost& ghost) {
-  auto p = std::find_if(ghost.history.begin(), ghost.history.end(), [] (const ghostmoment gm) { return gm.step > ticks - race_start_tick;} );
-  return p == ghost.history.end();
+  return ghost_position(ghost) == isize(ghost.history);
   }
 
 ghostmoment& get_ghostmoment(ghost& ghost) {
-  auto p = std::find_if(ghost.history.begin(), ghost.history.end(), [] (const ghostmoment gm) { return gm.step > ticks - race_start_tick;} );
-  if(p == ghost.history.end()) p--, p->footphase = 0;
-  return *p;
+  int at = ghost_position(ghost);
+  if(at == isize(ghost.history)) at--, ghost.history[at].footphase = 0;
+  return ghost.history[at];
   }
 
 void draw_ghost(ghost& ghost) {
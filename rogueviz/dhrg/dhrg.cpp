@@ -196,6 +196,14 @@ int dhrgArgs() {
     shift(); lc_type = args()[0];
     }
 
+  else if(argis("-dhrg-threads")) {
+    shift(); threads = argi();
+    }
+
+  else if(argis("-dhrg-batch")) {
+    shift(); move_batch = argi();
+    }
+
   else if(argis("-loadtest")) {
     dhrg_init(); load_test();
     }
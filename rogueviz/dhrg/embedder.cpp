@@ -20,7 +20,222 @@ bool dorestart = false;
 
 int lastmoves;
 
+void remove_vertex(int i, mycell *mc) {
+  tallyedgesof(i, -1, mc);
+  add_to_set(mc, -1, 0);
+  add_to_tally(mc, -1, 0);
+  }
+
+void insert_vertex(int i, mycell *mc) {
+  tallyedgesof(i, 1, mc);
+  add_to_tally(mc, 1, 0);
+  add_to_set(mc, 1, 0);
+  }
+
+void mark_tomove(int i) {
+  tomove[i] = true;
+  for(auto p: rogueviz::vdata[i].edges) {
+    int j = p.second->i ^ p.second->j ^ i;
+    tomove[j] = true;
+    }
+  }
+
+// try to move vertex i to the best neighboring cell; llo is the current loglikelihood
+bool move_vertex(int i, ld& llo) {
+  tomove[i] = false;
+  mycell *mc = vertices[i];
+  remove_vertex(i, mc);
+  mycell *mc2[FULL_EDGE];
+  ld llo2[FULL_EDGE];
+  int bestd = -1;
+  ld bestllo = llo;
+  
+  auto nei = allneighbors(mc);
+  
+  for(int d=0; d<isize(nei); d++) {
+    mc2[d] = nei[d];
+    if(mc2[d]->lev >= distlimit) continue;
+    tallyedgesof(i, 1, mc2[d]);
+    add_to_tally(mc2[d], 1, 0);
+    if(lc_type == 'C')
+      add_to_set(mc2[d], 1, 0);
+    llo2[d] = loglik_chosen();
+    if(lc_type == 'C')
+      add_to_set(mc2[d], -1, 0);
+    if(llo2[d] > bestllo) bestd = d, bestllo = llo2[d];
+    
+    add_to_tally(mc2[d], -1, 0);
+    tallyedgesof(i, -1, mc2[d]);
+    }
+  if(bestd >= 0) {
+    newmoves++;
+    vertices[i] = mc = mc2[bestd];
+    llo = llo2[bestd];
+    mark_tomove(i);
+    }
+  insert_vertex(i, mc);
+  return bestd >= 0;
+  }
+
+string moves_per_second(int moves, int t0) {
+  int t = max<int>(SDL_GetTicks() - t0, 1);
+  return fts(moves * 1000. / t) + " moves/s";
+  }
+
+/* number of vertices evaluated in parallel by movearound; 0 = sequential */
+int move_batch = 0;
+
+struct move_candidate {
+  int i;
+  vector<mycell*> nei;
+  int bestd;
+  ld bestllo;
+  bool missing;
+  };
+
+/* evaluate the moves of m.i against the current tallies without changing
+ * anything shared: the tallies are copied, and vertex m.i stays in the set,
+ * so the pairs it forms with itself and its candidate positions are corrected
+ * by hand. If the shared structure would need to be extended, m.missing is set.
+ */
+void evaluate_move(move_candidate& m, ld llo) {
+  using namespace rogueviz;
+  int i = m.i;
+  mycell *mc = vertices[i];
+  ll t[MAXDIST];
+  int e[MAXDIST], lev[BOXSIZE];
+  for(int u=0; u<MAXDIST; u++) t[u] = tally[u], e[u] = edgetally[u];
+  auto root = getsegment(mroot, mroot, 0, false);
+  for(int j=0; j<BOXSIZE; j++) lev[j] = root->qty[j];
+
+  static thread_local vector<int> seen;
+  if(isize(seen) < segmentids) seen.resize(segmentids, -1);
+  whichtally = t; seen_override = &seen; structure_frozen = true;
+  read_tally = t; read_edgetally = e; read_levels = lev;
+  m.bestd = -1; m.bestllo = llo; m.missing = false;
+
+  auto edges = [&] (mycell *at, int delta) {
+    for(auto p: vdata[i].edges) {
+      int j = p.second->i ^ p.second->j ^ i;
+      e[quickdist(at, vertices[j], 0)] += delta;
+      }
+    };
+
+  try {
+    add_to_tally(mc, -1, 0); t[0]++;
+    edges(mc, -1);
+    lev[mc->lev]--;
+    for(int d=0; d<isize(m.nei); d++) {
+      mycell *m2 = m.nei[d];
+      if(m2->lev >= distlimit) continue;
+      int selfdist = quickdist(m2, mc, 0);
+      add_to_tally(m2, 1, 0); t[selfdist]--;
+      edges(m2, 1);
+      if(lc_type == 'C') lev[m2->lev]++;
+      ld llo2 = loglik_chosen();
+      if(lc_type == 'C') lev[m2->lev]--;
+      if(llo2 > m.bestllo) m.bestd = d, m.bestllo = llo2;
+      edges(m2, -1);
+      add_to_tally(m2, -1, 0); t[selfdist]++;
+      }
+    }
+  catch(structure_missing&) {
+    m.missing = true;
+    for(segment *p: acknowledged) seen[p->id] = -1;
+    acknowledged.clear();
+    }
+
+  whichtally = tally; seen_override = nullptr; structure_frozen = false;
+  read_tally = tally; read_edgetally = edgetally; read_levels = nullptr;
+  }
+
+/* like movearound, but vertices without common edges are evaluated in
+ * batches of move_batch, in parallel. Since two vertices of a batch may
+ * still be counted in each other's tally, every chosen move is checked
+ * against the actual loglikelihood when committed, and undone if it does
+ * not improve it. The result does not depend on the number of threads.
+ */
+int movearound_parallel() {
+  indenter_finish im("movearound_parallel");
+  int total = 0;
+  if(smartmove) for(bool b: tomove) if(b) total++;
+  if(total == 0) {
+    tomove.resize(0), tomove.resize(N, true);
+    }
+  int moves = 0, fallbacks = 0, rejected = 0;
+  ld llo = loglik_chosen();
+  int t0 = SDL_GetTicks();
+
+  vector<int> pending(N);
+  for(int i=0; i<N; i++) pending[i] = i;
+  vector<char> blocked(N, false);
+  vector<move_candidate> batch;
+
+  {progressbar pb(N, "tomove: " + its(total) + " (last: " + its(lastmoves) + ")");
+  while(!pending.empty()) {
+    // pick the vertices in order, deferring those adjacent to an already picked one
+    batch.clear();
+    vector<int> rest;
+    for(int k=0; k<isize(pending); k++) {
+      int i = pending[k];
+      if(isize(batch) >= move_batch || k >= 4 * move_batch) {
+        rest.insert(rest.end(), pending.begin() + k, pending.end());
+        break;
+        }
+      if(!tomove[i]) { pb++; continue; }
+      if(blocked[i]) { rest.push_back(i); continue; }
+      batch.emplace_back();
+      batch.back().i = i;
+      batch.back().nei = allneighbors(vertices[i]);
+      // the structure the evaluation needs is created here, as far as cheaply possible
+      prepare_ack(vertices[i], 0);
+      for(mycell *m2: batch.back().nei) if(m2->lev < distlimit) prepare_ack(m2, 0);
+      blocked[i] = true;
+      for(auto p: rogueviz::vdata[i].edges) blocked[p.second->i ^ p.second->j ^ i] = true;
+      }
+    pending.swap(rest);
+
+    parallelize(isize(batch), [&] (int a, int b) {
+      for(int k=a; k<b; k++) evaluate_move(batch[k], llo);
+      return 0;
+      });
+
+    for(auto& m: batch) {
+      int i = m.i;
+      blocked[i] = false;
+      for(auto p: rogueviz::vdata[i].edges) blocked[p.second->i ^ p.second->j ^ i] = false;
+      pb++;
+      if(m.missing) {
+        fallbacks++;
+        if(move_vertex(i, llo)) moves++;
+        continue;
+        }
+      tomove[i] = false;
+      if(m.bestd < 0) continue;
+      mycell *mc = vertices[i], *mc2 = m.nei[m.bestd];
+      remove_vertex(i, mc);
+      insert_vertex(i, mc2);
+      ld llo2 = loglik_chosen();
+      if(llo2 > llo) {
+        moves++; newmoves++;
+        vertices[i] = mc2;
+        llo = llo2;
+        mark_tomove(i);
+        }
+      else {
+        remove_vertex(i, mc2);
+        insert_vertex(i, mc);
+        rejected++;
+        }
+      }
+    pb.name = "moves: " + its(moves) + " (" + moves_per_second(moves, t0) + ")";
+    }}
+  println(hlog, " moves = ", moves, " (", moves_per_second(moves, t0), ", ", fallbacks, " evaluated sequentially, ", rejected, " rejected)");
+  return lastmoves = moves;
+  }
+
 int movearound() {
+  if(move_batch) return movearound_parallel();
   indenter_finish im("movearound");
   int total = 0;
   if(smartmove) for(bool b: tomove) if(b) total++;
@@ -29,57 +244,17 @@ int movearound() {
     }
   int moves = 0;
   ld llo = loglik_chosen();
-//  int im = 0;
+  int t0 = SDL_GetTicks();
   
   {progressbar pb(N, "tomove: " + its(total) + " (last: " + its(lastmoves) + ")");
   for(int i=0; i<N; i++) {
     if(!tomove[i]) { pb++; continue; }
-    tomove[i] = false;
     // if(i && i % 100 == 0) dispnewmoves();
-    mycell *mc = vertices[i];
-    tallyedgesof(i, -1, mc);
-    add_to_set(mc, -1, 0);
-    add_to_tally(mc, -1, 0);
-//    im += size(rogueviz::vdata[i].edges);
-    mycell *mc2[FULL_EDGE];
-    ld llo2[FULL_EDGE];
-    int bestd = -1;
-    ld bestllo = llo;
-    
-    auto nei = allneighbors(mc);
-    
-    for(int d=0; d<isize(nei); d++) {
-      mc2[d] = nei[d];
-      if(mc2[d]->lev >= distlimit) continue;
-      tallyedgesof(i, 1, mc2[d]);
-      add_to_tally(mc2[d], 1, 0);
-      if(lc_type == 'C')
-        add_to_set(mc2[d], 1, 0);
-      llo2[d] = loglik_chosen();
-      if(lc_type == 'C')
-        add_to_set(mc2[d], -1, 0);
-      if(llo2[d] > bestllo) bestd = d, bestllo = llo2[d];
-      
-      add_to_tally(mc2[d], -1, 0);
-      tallyedgesof(i, -1, mc2[d]);
-      }
-    if(bestd >= 0) {
-      moves++; newmoves++;
-      vertices[i] = mc = mc2[bestd];
-      llo = llo2[bestd];
-      tomove[i] = true;
-      for(auto p: rogueviz::vdata[i].edges) {
-        int j = p.second->i ^ p.second->j ^ i;
-        tomove[j] = true;
-        }
-      }
-    tallyedgesof(i, 1, mc);
-    add_to_tally(mc, 1, 0);
-    add_to_set(mc, 1, 0);
+    if(move_vertex(i, llo)) moves++;
     pb++;
     }}
   // dispnewmoves();
-  println(hlog, " moves = ", moves);
+  println(hlog, " moves = ", moves, " (", moves_per_second(moves, t0), ")");
   return lastmoves = moves;
   }
 
@@ -13,6 +13,14 @@ ld llcont_approx_prec = 10000;
 
 int edgetally[MAXDIST];
 
+// the log-likelihood functions below read the tallies through these pointers,
+// so that parallel move evaluation can use per-thread copies; read_levels
+// replaces the per-level counts of the root segment when not NULL
+
+thread_local ll *read_tally = tally;
+thread_local int *read_edgetally = edgetally;
+thread_local int *read_levels;
+
 void tallyedgesof(int i, int delta, mycell *mc) {
   using namespace rogueviz;
   for(auto p: vdata[i].edges) {
@@ -182,7 +190,7 @@ ld loglik_placement() {
   ld placement_loglik = 0;  
   auto seg = getsegment(root,root,0);
   for(int j=0; j<BOXSIZE; j++) {
-    int qj = seg->qty[j];
+    int qj = read_levels ? read_levels[j] : seg->qty[j];
     if(!qj) continue;
     placement_loglik += qj * (log(qj*1./N) - cgi.expansion->get_descendants(j).log_approx());
     }
@@ -193,9 +201,9 @@ ld loglik_placement() {
 
 ld loglik_logistic(logistic& l = current_logistic) {
   ld result = 0;
-  for(int u=0; u<MAXDIST; u++) if(edgetally[u] && tally[u]-edgetally[u]) {
-    result += edgetally[u] * l.lyes(u) +
-      (tally[u]-edgetally[u]) * l.lno(u);
+  for(int u=0; u<MAXDIST; u++) if(read_edgetally[u] && read_tally[u]-read_edgetally[u]) {
+    result += read_edgetally[u] * l.lyes(u) +
+      (read_tally[u]-read_edgetally[u]) * l.lno(u);
     }
   return result;
   }
@@ -204,7 +212,7 @@ ld loglik_logistic(logistic& l = current_logistic) {
 
 ld loglikopt() {
   ld result = 0;
-  for(int u=0; u<MAXDIST; u++) result += bestll2(edgetally[u], tally[u]);
+  for(int u=0; u<MAXDIST; u++) result += bestll2(read_edgetally[u], read_tally[u]);
   return result;
   }
 
@@ -214,7 +222,7 @@ ld loglikopt_mono() {
   vector<pair<ld, ld> > pairs;
   ld result = 0;
   for(int u=0; u<MAXDIST; u++) {
-    auto p = make_pair<ld,ld> (edgetally[u], tally[u]);
+    auto p = make_pair<ld,ld> (read_edgetally[u], read_tally[u]);
     if(p.second == 0) continue;
     while(isize(pairs)) {
       auto pb = pairs.back();
@@ -5,6 +5,14 @@ namespace dhrg {
 
 int mycellcount;
 
+/* set in the threads evaluating moves in parallel: the mycell and segment
+ * structure is shared then, so it must not be extended */
+thread_local bool structure_frozen;
+
+struct structure_missing {};
+
+void need_structure() { if(structure_frozen) throw structure_missing(); }
+
 struct segmentlist {
   segment *s;
   segmentlist *next;
@@ -81,6 +89,7 @@ mycell *find_mycell(cell *c) {
 void mycell::build() {
   const auto m = this;
   if(m->leftsibling) return; // already computed
+  need_structure();
   cell *c2[MAX_EDGE+1];
   int dist[MAX_EDGE+1];
   int t = m->c->type;
@@ -155,6 +164,7 @@ void generate_root() {
 
 mycell* mycell::gleftsibling() {
   if(leftsibling) return leftsibling;
+  need_structure();
   leftparent->gchildren();
   if(!leftsibling) {
     printf("error: no left sibling found\n");
@@ -165,6 +175,7 @@ mycell* mycell::gleftsibling() {
 
 mycell* mycell::grightsibling() {
   if(rightsibling) return rightsibling;
+  need_structure();
   rightparent->gchildren();
   if(!rightsibling) {
     printf("error: no right sibling found\n");
@@ -174,6 +185,7 @@ mycell* mycell::grightsibling() {
 
 mycell* mycell::gleftchild() {  
   if(leftchild) return leftchild;
+  need_structure();
   leftchild = new mycell();
   leftchild->leftparent = gleftsibling();
   leftchild->rightparent = this;
@@ -185,6 +197,7 @@ mycell* mycell::gleftchild() {
 void mycell::gchildren() {
   mycell *child = gleftchild();
   if(child->rightsibling) return;  
+  need_structure();
   bool first = true;
   for(int c: cgi.expansion->children[type]) {
     if(first) {
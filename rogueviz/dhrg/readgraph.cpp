@@ -24,28 +24,40 @@ namespace dhrg {
 
     any = rogueviz::add_edgetype("embedded edges");
     rogueviz::fname = fn;
-    fhstream f(fn + "-coordinates.txt", "rt");
-    if(!f.f) {
+    rogueviz::graph_file f(fn + "-coordinates.txt", "dhrg-coordinates", true, [] (const char*& p, const char *end, rogueviz::graph_chunk& out) {
+      auto s = rogueviz::read_token(p, end);
+      if(s == "" || s == "#ROGUEVIZ_ENDOFDATA") return false;
+      ld r, alpha;
+      if(!rogueviz::read_number(p, end, r) || !rogueviz::read_number(p, end, alpha)) { out.error = "incorrect format of r/alpha"; return false; }
+      out.labels.push_back(s);
+      out.values.push_back(r);
+      out.values.push_back(alpha);
+      return true;
+      });
+    if(!f.ok) {
       printf("Missing file: %s-coordinates.txt\n", rogueviz::fname.c_str());
       exit(1);
       }
     printf("Reading coordinates...\n");
-    string ignore;
-    if(!scan(f, ignore, ignore, ignore, ignore, N, graph_R, graph_alpha, graph_T)) {
+    if(isize(f.header) < 8) {
       printf("Error: incorrect format of the first line\n"); exit(1);
       }
+    N = atoi(f.header[4].c_str());
+    graph_R = atof(f.header[5].c_str());
+    graph_alpha = atof(f.header[6].c_str());
+    graph_T = atof(f.header[7].c_str());
+    if(f.error != "") { printf("Error: %s\n", f.error.c_str()); exit(1); }
     rogueviz::vdata.reserve(N);
-    while(true) {
-      string s = scan<string>(f);
-      if(s == "D11.11") tst();
-      if(s == "" || s == "#ROGUEVIZ_ENDOFDATA") break;
-      int id = rogueviz::getid(s);
+    auto ids = f.intern();
+    coords.reserve(isize(coords) + isize(f.refs));
+    for(int k=0; k<isize(f.refs); k++) {
+      int id = ids[f.refs[k]];
+      if(f.labels[f.refs[k]] == "D11.11") tst();
       rogueviz::vertexdata& vd(rogueviz::vdata[id]);
-      vd.name = s;
+      vd.name = f.labels[f.refs[k]];
       vd.cp = rogueviz::colorpair(rogueviz::dftcolor);
       
-      double r, alpha;
-      if(!scan(f, r, alpha)) { printf("Error: incorrect format of r/alpha\n"); exit(1); }
+      double r = f.values[2*k], alpha = f.values[2*k+1];
       coords.push_back(make_pair(r, alpha));
   
       transmatrix h = spin(alpha * degree) * xpush(r);
@@ -53,19 +65,23 @@ namespace dhrg {
       rogueviz::createViz(id, currentmap->gamestart(), h);
       }
     
-    fhstream g(fn + "-links.txt", "rt");
-    if(!g.f) {
+    rogueviz::graph_file g(fn + "-links.txt", "dhrg-links", false, [] (const char*& p, const char *end, rogueviz::graph_chunk& out) {
+      auto i = rogueviz::read_token(p, end), j = rogueviz::read_token(p, end);
+      if(i == "" || j == "") return false;
+      out.labels.push_back(i);
+      out.labels.push_back(j);
+      return true;
+      });
+    if(!g.ok) {
       println(hlog, "Missing file: ", rogueviz::fname, "-links.txt");
       exit(1);
       }
     println(hlog, "Reading links...");
-    int qlink = 0;
-    while(true) {
-      int i = rogueviz::readLabel(g), j = rogueviz::readLabel(g);
-      if(i == -1 || j == -1) break;
-      addedge(i, j, 1, subdiv, any);
-      qlink++;
-      }
+    auto lids = g.intern();
+    int qlink = isize(g.refs) / 2;
+    rogueviz::edgeinfos.reserve(isize(rogueviz::edgeinfos) + qlink);
+    for(int k=0; k<qlink; k++)
+      addedge(lids[g.refs[2*k]], lids[g.refs[2*k+1]], 1, subdiv, any);
   
     if(doRebase) {
       printf("Rebasing...\n");
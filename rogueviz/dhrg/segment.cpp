@@ -2,7 +2,7 @@
 
 namespace dhrg {
 
-int segmentcount;
+int segmentcount, segmentids;
 
 struct qtybox {
   int minv, maxv;
@@ -25,7 +25,8 @@ struct segment {
   segment *firstchild;
   qtybox qty;
   int seen;
-  segment() { seen = -1; segmentcount++; }
+  int id;
+  segment() { seen = -1; id = segmentids++; segmentcount++; }
   ~segment() { segmentcount--; }
   };
 
@@ -39,6 +40,7 @@ segment *getsegment(mycell *pleft, mycell *pright, int setid, bool docreate = tr
     c1 = c1 -> nextleft;
     }
   if(!docreate) return c1;
+  need_structure();
   segment *p = new segment;
   p->left = pleft;
   p->right = pright;
@@ -72,9 +74,16 @@ segment *getsegment(mycell *pleft, mycell *pright, int setid, bool docreate = tr
 
 ll tally[MAXDIST];
 
-ll *whichtally = tally;
+thread_local ll *whichtally = tally;
 
-vector<segment*> acknowledged;
+thread_local vector<segment*> acknowledged;
+
+/* while the segments are shared between threads, the seen values are kept here (indexed by segment::id) instead of in segment::seen */
+thread_local vector<int> *seen_override;
+
+int& seen_of(segment *p) {
+  return seen_override ? (*seen_override)[p->id] : p->seen;
+  }
 
 void tallybox(qtybox& box, int d, int mul) {
   for(int i=box.minv; i<box.maxv; i++)
@@ -83,27 +92,28 @@ void tallybox(qtybox& box, int d, int mul) {
 
 void acknowledge(segment *p, int d) {
   if(!p) return;
-  if(p->seen == -1) {
-    p->seen = d;
+  int& seen = seen_of(p);
+  if(seen == -1) {
+    seen = d;
     acknowledged.emplace_back(p);
     }
-  else if(p->seen > d) 
-    p->seen = d;
+  else if(seen > d) 
+    seen = d;
   }
 
 void acknowledgments(int mul) {
   for(segment* p: acknowledged) {
-    tallybox(p->qty, p->seen, mul);
+    tallybox(p->qty, seen_of(p), mul);
     segment *p2 = p->parent;
     int dist = 1;
     while(p2) {
-      if(p2->seen != -1) {
-        tallybox(p->qty, p2->seen+dist, -mul);
+      if(seen_of(p2) != -1) {
+        tallybox(p->qty, seen_of(p2)+dist, -mul);
         break;
         }
       p2=p2->parent; dist++;
       }
-    p->seen = -1;
+    seen_of(p) = -1;
     }
   acknowledged.clear();
   }
@@ -195,6 +205,21 @@ void build_ack(mycell *c, int setid) {
     }
   }
 
+/* create the mycells and segments which build_ack(c, setid) is going to visit,
+ * without computing anything -- much faster than build_ack itself */
+void prepare_ack(mycell *c, int setid) {
+  segment *p = getsegment(c, c, setid);
+  int sl = cgi.expansion->sibling_limit;
+  while(p) {
+    mycell *m = p->right;
+    for(int u=0; u<=sl; u++) m->build(), m = m->grightsibling();
+    m = p->left;
+    for(int u=0; u<=sl; u++) m->build(), m = m->gleftsibling();
+    if(sl > 3) getsegment(p->right, p->right, setid), getsegment(p->left, p->left, setid);
+    p = p->parent;
+    }
+  }
+
 void add_to_tally(mycell *c, int mul, int setid) {
   build_ack(c, setid);
   acknowledgments(mul);
@@ -0,0 +1,217 @@
+// RogueViz -- reading large graph and sample files
+// Copyright (C) 2011-24 Zeno Rogue, see 'hyper.cpp' for details
+
+#include "rogueviz.h"
+#ifdef LINUX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace rogueviz {
+
+bool use_graph_cache = false;
+
+mapped_file::mapped_file(const string& fname) {
+  #ifdef LINUX
+  int fd = ::open(fname.c_str(), O_RDONLY);
+  if(fd == -1) return;
+  struct stat st;
+  if(fstat(fd, &st) == 0) {
+    size = st.st_size;
+    mtime = st.st_mtime;
+    ok = true;
+    if(size) {
+      void *m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(m != MAP_FAILED) {
+        data = (const char*) m; mapped = true;
+        madvise(m, size, MADV_SEQUENTIAL);
+        }
+      }
+    }
+  ::close(fd);
+  if(data || !ok || !size) return;
+  #endif
+  FILE *f = fopen(fname.c_str(), "rb");
+  if(!f) { ok = false; return; }
+  char buf[1<<16];
+  while(true) {
+    size_t q = fread(buf, 1, sizeof(buf), f);
+    if(!q) break;
+    buffer.append(buf, q);
+    }
+  fclose(f);
+  data = buffer.data(); size = buffer.size(); ok = true;
+  }
+
+mapped_file::~mapped_file() {
+  #ifdef LINUX
+  if(mapped) munmap((void*) data, size);
+  #endif
+  }
+
+static bool is_space(char c) { return c == 32 || (c >= 9 && c <= 13); }
+
+bool skip_spaces(const char*& p, const char *end) {
+  while(p < end && is_space(*p)) p++;
+  return p < end;
+  }
+
+std::string_view read_token(const char*& p, const char *end) {
+  skip_spaces(p, end);
+  const char *s = p;
+  while(p < end && !is_space(*p)) p++;
+  return std::string_view(s, p - s);
+  }
+
+bool read_number(const char*& p, const char *end, ld& x) {
+  if(!skip_spaces(p, end)) return false;
+  /* the mapped data is not null-terminated, so strtod works on a copy */
+  char buf[80];
+  int q = 0;
+  while(q < 79 && p+q < end && !is_space(p[q])) buf[q] = p[q], q++;
+  buf[q] = 0;
+  char *stop;
+  x = strtod(buf, &stop);
+  if(stop == buf) return false;
+  p += stop - buf;
+  return true;
+  }
+
+bool read_label(const char*& p, const char *end, char delim, graph_chunk& out, std::string_view& res) {
+  const char *s = p;
+  bool filtered = false;
+  while(p < end && *p != delim) { if(rv_ignore(*p)) filtered = true; p++; }
+  if(p == end) return false;
+  res = std::string_view(s, p - s);
+  p++;
+  if(!filtered) return true;
+  string t;
+  for(char c: res) if(!rv_ignore(c)) t += c;
+  res = out.own(std::move(t));
+  return true;
+  }
+
+/** parse the records in [p, cend); records may extend up to end */
+static void read_chunk(const char *p, const char *cend, const char *end, const record_reader& reader, graph_chunk& out) {
+  out.stop = p;
+  while(skip_spaces(p, end) && p < cend) {
+    if(!reader(p, end, out)) { out.finished = true; break; }
+    out.stop = p;
+    }
+  }
+
+static string cache_name(const string& fname) { return fname + ".rvcache"; }
+
+static const string graph_cache_magic = "RVGRAPH1";
+
+bool graph_file::load_cache(const string& fname, const string& tag, const mapped_file& mf) {
+  if(!file_exists(cache_name(fname))) return false;
+  try {
+    fhstream f(cache_name(fname), "rb");
+    if(!f.f) return false;
+    if(f.get<string>() != graph_cache_magic || f.get<string>() != tag) return false;
+    if(f.get<long long>() != (long long) mf.size || f.get<long long>() != mf.mtime) return false;
+    f.read(header); f.read(labels); f.read(refs); f.read(values);
+    return true;
+    }
+  catch(hstream_exception& e) {
+    header.clear(); labels.clear(); refs.clear(); values.clear();
+    return false;
+    }
+  }
+
+void graph_file::save_cache(const string& fname, const string& tag, const mapped_file& mf) {
+  try {
+    fhstream f(cache_name(fname), "wb");
+    if(!f.f) return;
+    f.write(graph_cache_magic); f.write(tag);
+    f.write<long long>(mf.size); f.write<long long>(mf.mtime);
+    f.write(header); f.write(labels); f.write(refs); f.write(values);
+    }
+  catch(hstream_exception& e) {
+    println(hlog, "failed to write the cache for ", fname);
+    }
+  }
+
+graph_file::graph_file(const string& fname, const string& tag, bool has_header, const record_reader& reader) {
+  mapped_file mf(fname);
+  if(!mf.ok) return;
+  ok = true;
+  if(use_graph_cache && load_cache(fname, tag, mf)) return;
+
+  const char *p = mf.data, *end = mf.data + mf.size;
+  if(has_header) {
+    const char *eol = (const char*) memchr(p, '\n', end - p);
+    if(!eol) eol = end;
+    while(true) {
+      auto t = read_token(p, eol);
+      if(t.empty()) break;
+      header.emplace_back(t);
+      }
+    p = eol;
+    }
+
+  /* split the data into chunks at line boundaries; each chunk is parsed in its own thread */
+  int nchunks = max<int>(threads, 1);
+  if(end - p < (1<<20)) nchunks = 1;
+  vector<const char*> starts;
+  for(int k=0; k<nchunks; k++) {
+    const char *s = p + (end - p) * k / nchunks;
+    if(k) {
+      s = max(s, starts.back());
+      while(s < end && s > p && s[-1] != '\n') s++;
+      }
+    starts.push_back(s);
+    }
+  starts.push_back(end);
+
+  vector<graph_chunk> chunks(nchunks);
+  parallelize(nchunks, [&] (int a, int b) {
+    for(int k=a; k<b; k++) read_chunk(starts[k], starts[k+1], end, reader, chunks[k]);
+    return 0;
+    });
+
+  /* a record crossing a chunk boundary means that records are not line-based after all */
+  for(int k=0; k+1<nchunks; k++) {
+    if(chunks[k].finished) break;
+    if(chunks[k].stop > starts[k+1]) {
+      chunks.clear(); chunks.resize(1);
+      read_chunk(p, end, end, reader, chunks[0]);
+      break;
+      }
+    }
+
+  std::unordered_map<std::string_view, int> index;
+  size_t qlabels = 0, qvalues = 0;
+  for(auto& ch: chunks) {
+    qlabels += ch.labels.size(); qvalues += ch.values.size();
+    if(ch.finished) break;
+    }
+  refs.reserve(qlabels); values.reserve(qvalues);
+  for(auto& ch: chunks) {
+    if(error == "") error = ch.error;
+    for(auto& l: ch.labels) {
+      auto it = index.find(l);
+      if(it != index.end()) { refs.push_back(it->second); continue; }
+      int id = isize(labels);
+      index.emplace(l, id);
+      labels.emplace_back(l);
+      refs.push_back(id);
+      }
+    values.insert(values.end(), ch.values.begin(), ch.values.end());
+    if(ch.finished) break;
+    }
+
+  if(use_graph_cache && error == "") save_cache(fname, tag, mf);
+  }
+
+vector<int> graph_file::intern() {
+  vector<int> ids(isize(labels));
+  vdata.reserve(isize(vdata) + isize(labels));
+  for(int i=0; i<isize(labels); i++) ids[i] = getid(labels[i]);
+  return ids;
+  }
+
+}
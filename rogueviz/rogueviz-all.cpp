@@ -2,6 +2,7 @@
 
 /* basics */
 #include "rogueviz.cpp"
+#include "graphfile.cpp"
 #include "presentation.cpp"
 #include "statshot.cpp"
 
@@ -949,6 +949,9 @@ int readArgs() {
   else if(argis("-rvspaces")) {
     rv_ignore_spaces = false;
     }
+  else if(argis("-rvcache")) {
+    shift(); use_graph_cache = argi();
+    }
   else if(argis("-rvlabelshift")) {
     shift_arg_formula(labelshift);
     }
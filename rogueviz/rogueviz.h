@@ -292,6 +292,65 @@ function<void(presmode)> roguevizslide_action(char c, const T& t, const U& act)
 
   bool rv_ignore(char c);
 
+  /** a whole input file, memory-mapped where possible */
+  struct mapped_file {
+    const char *data = nullptr;
+    size_t size = 0;
+    long long mtime = 0;
+    bool ok = false;
+    explicit mapped_file(const string& fname);
+    ~mapped_file();
+    mapped_file(const mapped_file&) = delete;
+    private:
+    bool mapped = false;
+    string buffer;
+    };
+
+  /** labels and numbers found in a part of a graph file */
+  struct graph_chunk {
+    vector<std::string_view> labels;
+    vector<ld> values;
+    /** labels which are not verbatim substrings of the file */
+    std::deque<string> owned;
+    /** where the last complete record ended */
+    const char *stop = nullptr;
+    /** the end of data has been reached, or an error was found */
+    bool finished = false;
+    string error;
+    std::string_view own(string s) { owned.push_back(std::move(s)); return owned.back(); }
+    };
+
+  /** reads a single record starting at p, adding its labels and values to the chunk; returns false at the end of data */
+  using record_reader = std::function<bool(const char*& p, const char *end, graph_chunk& out)>;
+
+  /** a graph (or sample) file split into records: the labels are interned, and the labels and values of all the records are listed in order */
+  struct graph_file {
+    /** tokens of the first line, if has_header */
+    vector<string> header;
+    /** distinct labels, in the order of the first appearance */
+    vector<string> labels;
+    /** label references of all the records, as indices to labels */
+    vector<int> refs;
+    vector<ld> values;
+    bool ok = false;
+    string error;
+    graph_file(const string& fname, const string& tag, bool has_header, const record_reader& reader);
+    /** getid for all the labels, in the order of the first appearance; returns the vertex ids */
+    vector<int> intern();
+    private:
+    bool load_cache(const string& fname, const string& tag, const mapped_file& mf);
+    void save_cache(const string& fname, const string& tag, const mapped_file& mf);
+    };
+
+  /** reuse the parsed contents of graph files, stored as fname.rvcache */
+  extern bool use_graph_cache;
+
+  bool skip_spaces(const char*& p, const char *end);
+  std::string_view read_token(const char*& p, const char *end);
+  bool read_number(const char*& p, const char *end, ld& x);
+  /** read characters until delim (which is consumed), skipping the ones for which rv_ignore holds */
+  bool read_label(const char*& p, const char *end, char delim, graph_chunk& out, std::string_view& res);
+
   colorpair perturb(colorpair cp);
   void queuedisk(const shiftmatrix& V, const colorpair& cp, bool legend, const string* info, int i);
 
@@ -225,6 +225,114 @@ void dofullsa_iterations(long long saiter) {
   create_viz();
   }
 
+/** a replica for parallel tempering: it has its own placement, RNG and temperature, and shares sagdist and the graph with the other replicas */
+struct sag_replica {
+  vector<int> id, node;
+  double cost;
+  ld temperature;
+  std::mt19937 rng;
+  long long iterations, moves;
+
+  int rand(int n) { return rng() % n; }
+
+  bool chance(double p) {
+    p *= double(rng.max()) + 1;
+    auto l = rng();
+    auto pv = (decltype(l)) p;
+    if(l < pv) return true;
+    if(l == pv) return chance(p-pv);
+    return false;
+    }
+
+  /** like saiter, but on this replica */
+  void iter() {
+    iterations++;
+    int DN = isize(id);
+    int t1 = rand(DN);
+    int sid1 = id[t1];
+
+    int sid2;
+
+    int s = twoway ? (rand(2) ? 4 : 1) : rand(4)+1;
+
+    if(s == 4) sid2 = rand(isize(sagcells));
+    else {
+      sid2 = sid1;
+      for(int ii=0; ii<s; ii++) sid2 = neighbors[sid2][rand(isize(neighbors[sid2]))];
+      }
+    int t2 = allow_doubles ? -1 : node[sid2];
+
+    node[sid1] = -1; id[t1] = -1;
+    node[sid2] = -1; if(t2 >= 0) id[t2] = -1;
+
+    double change =
+      costat(t1,sid2,id,node) + costat(t2,sid1,id,node) - costat(t1,sid1,id,node) - costat(t2,sid2,id,node);
+
+    node[sid1] = t1; id[t1] = sid1;
+    node[sid2] = t2; if(t2 >= 0) id[t2] = sid2;
+
+    if(change > 0 && !chance(exp(-change * exp(-temperature)))) return;
+    moves++;
+
+    node[sid1] = t2; node[sid2] = t1;
+    id[t1] = sid2; if(t2 >= 0) id[t2] = sid1;
+    cost += change;
+    }
+  };
+
+/** parallel tempering: K replicas at temperatures evenly spaced from lowtemp to hightemp run iters iterations each, in rogueviz::threads threads;
+ *  every swap_each iterations, the replicas at neighboring temperatures may exchange their placements. The best placement found is written back to sagid */
+void parallel_tempering(int K, long long iters, int swap_each) {
+  vector<sag_replica> reps(K);
+  for(int k=0; k<K; k++) {
+    auto& r = reps[k];
+    r.id = sagid; r.node = sagnode; r.cost = cost;
+    r.temperature = K == 1 ? lowtemp : lowtemp + (hightemp - lowtemp) * k / (K-1.);
+    r.rng.seed(hrngen());
+    r.iterations = r.moves = 0;
+    }
+  vector<int> record = sagid;
+  double record_cost = cost;
+  int swaps = 0, swap_tries = 0;
+  int t0 = SDL_GetTicks();
+
+  for(long long done=0; done<iters; done += swap_each) {
+    long long len = min<long long>(swap_each, iters - done);
+    parallelize(K, [&] (int a, int b) {
+      for(int k=a; k<b; k++) for(long long i=0; i<len; i++) reps[k].iter();
+      return 0;
+      });
+    for(auto& r: reps) if(r.cost < record_cost) record_cost = r.cost, record = r.id;
+    for(int k=0; k+1<K; k++) {
+      auto& r1 = reps[k];
+      auto& r2 = reps[k+1];
+      swap_tries++;
+      ld p = exp((exp(-r1.temperature) - exp(-r2.temperature)) * (r1.cost - r2.cost));
+      if(p >= 1 || chance(p)) {
+        swaps++;
+        swap(r1.id, r2.id); swap(r1.node, r2.node); swap(r1.cost, r2.cost);
+        }
+      }
+    if(output_fullsa)
+      println(hlog, format("it %12lld best %9.2f coldest %9.2f swaps %d/%d", done + len, record_cost, reps[0].cost, swaps, swap_tries));
+    }
+
+  int t = max<int>(SDL_GetTicks() - t0, 1);
+  long long total = 0;
+  for(auto& r: reps) {
+    println(hlog, format("temp %8.4f cost %9.2f moves %12lld it/s %12.0f", double(r.temperature), r.cost, r.moves, r.iterations * 1000. / t));
+    total += r.iterations;
+    }
+  println(hlog, format("replicas %d total it/s %12.0f", K, total * 1000. / t));
+
+  sagid = record;
+  for(auto& n: sagnode) n = -1;
+  for(int i=0; i<isize(sagid); i++) sagnode[sagid[i]] = i;
+  compute_cost();
+  numiter += total;
+  create_viz();
+  }
+
 int anneal_read_args() {
 #if CAP_COMMANDLINE
   using namespace arg;
@@ -242,6 +350,12 @@ int anneal_read_args() {
   else if(argis("-sagfulli")) {
     shift(); sag::dofullsa_iterations(argll());
     }
+  else if(argis("-sag-pt")) {
+    shift(); int K = argi();
+    shift(); long long iters = argll();
+    shift(); int swap_each = argi();
+    parallel_tempering(K, iters, swap_each);
+    }
   else if(argis("-sagmode")) {
     shift();
     vizsa_start = 0;
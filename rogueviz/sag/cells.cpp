@@ -46,6 +46,9 @@ bool dijkstra_tile;
 
 string distance_file;
 
+/** compute the distances on demand instead of the N*N table: 1 = celldistance (no subcells), 2 = geometric distance (pdist with gdist_prec) */
+int distance_oracle;
+
 ld pdist(hyperpoint hi, hyperpoint hj);  
 
 /** the maximum value in sagdist +1 */
@@ -63,12 +66,61 @@ struct sagdist_t {
   size_t N;
   int format;
 
+  /** if set, the distances are not stored in tab, but computed by the oracle on demand and memoised in tiles, see cached */
+  std::function<int(int, int)> oracle;
+
+  /** the number of tiles memoised by each thread; the older half is dropped when this is exceeded */
+  int max_tiles;
+
+  /** changed whenever the distances change, to invalidate the memoised tiles */
+  int generation;
+
+  static constexpr int TILE = 64;
+
+  /** the table is iterable only if it is stored */
   distance* begin() { return tab; }
-  distance* end() { return tab+N*N; }
+  distance* end() { return tab ? tab+N*N : tab; }
 
-  sagdist_t() { tab = nullptr; fd = 0; format = 1; }
+  sagdist_t() { tab = nullptr; fd = 0; format = 1; max_tiles = 4096; generation = 0; }
 
-  distance* operator [] (int y) { return tab + N * y; }
+  struct row {
+    sagdist_t *s;
+    size_t y;
+    distance& operator [] (size_t x) const { return s->tab ? s->tab[s->N * y + x] : s->cached(y, x); }
+    };
+
+  row operator [] (int y) { return row{this, size_t(y)}; }
+
+  /** the oracle distance, memoised in TILE x TILE tiles; each thread has its own tiles, so the replicas of parallel tempering do not need locks */
+  distance& cached(size_t y, size_t x) {
+    struct tile { vector<distance> d; long long last_use; };
+    struct tilecache { int generation = -1; long long uses = 0; std::unordered_map<size_t, tile> tiles; };
+    static thread_local tilecache tc;
+    if(tc.generation != generation) tc.tiles.clear(), tc.generation = generation;
+    size_t id = (y / TILE) * ((N + TILE - 1) / TILE) + x / TILE;
+    auto it = tc.tiles.find(id);
+    if(it == tc.tiles.end()) {
+      if(isize(tc.tiles) >= max_tiles) {
+        vector<long long> uses;
+        for(auto& p: tc.tiles) uses.push_back(p.second.last_use);
+        auto mid = uses.begin() + isize(uses) / 2;
+        std::nth_element(uses.begin(), mid, uses.end());
+        for(auto it1 = tc.tiles.begin(); it1 != tc.tiles.end();)
+          if(it1->second.last_use <= *mid) it1 = tc.tiles.erase(it1); else it1++;
+        }
+      it = tc.tiles.emplace(id, tile{vector<distance>(TILE * TILE, UNKNOWN), 0}).first;
+      }
+    it->second.last_use = ++tc.uses;
+    auto& d = it->second.d[(y % TILE) * TILE + x % TILE];
+    if(d == UNKNOWN) d = oracle(y, x);
+    return d;
+    }
+
+  void set_oracle(int _N, const std::function<int(int, int)>& f) {
+    clear();
+    N = _N;
+    oracle = f;
+    }
 
   void init(int _N, distance val) {
     clear();
@@ -96,6 +148,51 @@ struct sagdist_t {
     }
   #endif
 
+  /** the file opened by stream_open, or -1 */
+  int stream_fd = -1;
+  bool stream_failed;
+
+  /** start writing a table of size _N directly to a file, in the format of save; the rows are given by put_row, possibly from multiple threads */
+  void stream_open(string fname, int _N) {
+    #ifdef LINUX
+    clear();
+    N = _N;
+    stream_fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if(stream_fd == -1) throw hr_exception("open failed in stream_open");
+    if(write(stream_fd, &N, 8) < 8) throw hr_exception("write error");
+    stream_failed = false;
+    #else
+    throw hr_exception("streaming sagdist requires LINUX");
+    #endif
+    }
+
+  void put_row(int y, const distance *row) {
+    if(stream_fd == -1) {
+      memcpy(tab + N * y, row, N * sizeof(distance));
+      return;
+      }
+    #ifdef LINUX
+    size_t size = N * sizeof(distance);
+    off_t pos = 8 + off_t(size) * y;
+    const char *p = (const char*) row;
+    while(size) {
+      auto written = pwrite(stream_fd, p, size, pos);
+      if(written <= 0) { stream_failed = true; return; }
+      p += written; pos += written; size -= written;
+      }
+    #endif
+    }
+
+  /** finish stream_open, and map the result */
+  void stream_close(string fname) {
+    ::close(stream_fd);
+    stream_fd = -1;
+    if(stream_failed) throw hr_exception("write error in stream_close");
+    #ifdef LINUX
+    map(fname);
+    #endif
+    }
+
   void load_old(string fname) {
     vector<vector<distance>> old;
     clear();
@@ -124,6 +221,7 @@ struct sagdist_t {
     }
 
   void save(string fname) {
+    if(!tab) throw hr_exception("the distances given by an oracle cannot be saved");
     fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
     if(write(fd, &N, 8) < 8) throw hr_exception("write error");
     size_t size =  N*N*sizeof(distance);
@@ -149,6 +247,7 @@ struct sagdist_t {
     #endif
     delete[] tab;
     tab = nullptr; fd = 0;
+    oracle = nullptr; generation++;
     }
 
   ~sagdist_t() {
@@ -180,6 +279,18 @@ void ensure_subcell_points() {
   if(isize(subcell_points) <= 1) subcell_points = { C0 };  
   }
 
+/** if set, compute_dists writes the rows of the table directly to this file, and then maps it */
+string stream_file;
+
+void start_table(int N) {
+  if(stream_file != "") sagdist.stream_open(stream_file, N);
+  else sagdist.init(N, N);
+  }
+
+void finish_table() {
+  if(stream_file != "") sagdist.stream_close(stream_file);
+  }
+
 void compute_dists() {
   int N = isize(sagcells);
 
@@ -223,11 +334,19 @@ void compute_dists() {
       cellpoint[visited[i]/Q*Q+q] = T0 * subcell_points[q];
     }
   
-  if(distance_file != "") {
+  if(distance_oracle == 1) {
+    if(Q > 1) throw hr_exception("celldistance oracle does not support subcells");
+    sagdist.set_oracle(N, [] (int i, int j) { return celldistance(sagcells[i].first, sagcells[j].first); });
+    }
+  else if(distance_oracle == 2) {
+    if(!gdist_prec) throw hr_exception("geometric distance oracle requires -sag_gdist");
+    sagdist.set_oracle(N, [] (int i, int j) { return int((pdist(cellpoint[i], cellpoint[j]) + .5) * gdist_prec); });
+    }
+  else if(distance_file != "") {
     sagdist.load(distance_file);
     }
   else if(gdist_prec && dijkstra_maxedge) {
-    sagdist.init(N, N);
+    start_table(N);
     println(hlog, "Computing Dijkstra distances...");
     vector<vector<pair<int, ld>>> dijkstra_edges(N);
     for(int i=0; i<N; i++) {
@@ -238,6 +357,7 @@ void compute_dists() {
       }
     parallelize(N, [&] (int a, int b) {
     vector<ld> distances(N);
+    vector<sagdist_t::distance> row(N);
     for(int i=a; i<b; i++) {
       if(i % 500 == 0) println(hlog, "computing dijkstra for ", i , "/", N);
       for(int j=0; j<N; j++) distances[j] = HUGE_VAL;
@@ -254,44 +374,78 @@ void compute_dists() {
         pq.pop();
         for(auto e: dijkstra_edges[at]) visit(e.first, d + e.second);
         }
-      for(int j=0; j<N; j++) sagdist[i][j] = distances[j] * gdist_prec + .5;
+      for(int j=0; j<N; j++) row[j] = distances[j] * gdist_prec + .5;
+      sagdist.put_row(i, row.data());
       }
     return 0;
     }
     );
+    finish_table();
     println(hlog, "N0 = ", neighbors[0]);
     println(hlog, "N1 = ", neighbors[1]);
     }
 
   else if(gdist_prec) {
-    sagdist.init(N, N);
+    start_table(N);
     println(hlog, "Computing distances... (N=", N, ")");
-    ld mx = 1;
-    for(int i=0; i<N; i++)
-    for(int j=0; j<N; j++) {
-      ld d = pdist(cellpoint[i], cellpoint[j]);
-      sagdist[i][j] = (d + .5) * gdist_prec;
-      if(d > mx) {
-        println(hlog, kz(cellpoint[i]), kz(cellpoint[j]), " :: ", mx = d);
+    parallelize(N, [&] (int a, int b) {
+      vector<sagdist_t::distance> row(N);
+      for(int i=a; i<b; i++) {
+        for(int j=0; j<N; j++) row[j] = (pdist(cellpoint[i], cellpoint[j]) + .5) * gdist_prec;
+        sagdist.put_row(i, row.data());
         }
-      }
+      return 0;
+      });
+    finish_table();
     }
   
   else {
     println(hlog, "no gdist_prec");
-    sagdist.init(N, N);
-    for(int i=0; i<N; i++) {
-      auto sdi = sagdist[i];
-      vector<int> q;
-      auto visit = [&] (int j, int dist) { if(sdi[j] < N) return; sdi[j] = dist; q.push_back(j); };
-      visit(i, 0);
-      for(int j=0; j<isize(q); j++) for(int k: neighbors[q[j]]) visit(k, sdi[q[j]]+1);
-      }
+    start_table(N);
+    /* bit-parallel BFS: each bit of the masks corresponds to one of the 64 sources of a batch */
+    int batches = (N + 63) / 64;
+    parallelize(batches, [&] (int a, int b) {
+      vector<unsigned long long> seen(N), frontier(N), next(N);
+      vector<sagdist_t::distance> rows(64 * size_t(N));
+      for(int batch=a; batch<b; batch++) {
+        int first = batch * 64, q = min(64, N - first);
+        for(auto& r: rows) r = N;
+        for(int j=0; j<N; j++) seen[j] = frontier[j] = 0;
+        for(int k=0; k<q; k++) {
+          seen[first+k] |= 1ull << k;
+          frontier[first+k] |= 1ull << k;
+          rows[size_t(k) * N + first + k] = 0;
+          }
+        for(int dist=1;; dist++) {
+          for(int j=0; j<N; j++) next[j] = 0;
+          bool any = false;
+          for(int j=0; j<N; j++) if(frontier[j])
+            for(int k: neighbors[j]) next[k] |= frontier[j];
+          for(int j=0; j<N; j++) {
+            auto m = next[j] & ~seen[j];
+            frontier[j] = m;
+            if(!m) continue;
+            any = true;
+            seen[j] |= m;
+            for(int k=0; k<q; k++) if(m >> k & 1) rows[size_t(k) * N + j] = dist;
+            }
+          if(!any) break;
+          }
+        for(int k=0; k<q; k++) sagdist.put_row(first+k, &rows[size_t(k) * N]);
+        }
+      return 0;
+      });
+    finish_table();
     }
   
   max_sag_dist = 0;
   for(auto x: sagdist) max_sag_dist = max<int>(max_sag_dist, x);
   max_sag_dist++;
+  if(sagdist.oracle) {
+    /* by the triangle inequality, with a margin for rounding */
+    for(int j=0; j<N; j++) max_sag_dist = max<int>(max_sag_dist, sagdist[0][j]);
+    max_sag_dist = 2 * max_sag_dist + 2;
+    }
   println(hlog, "max_sag_dist = ", max_sag_dist);
   }
 
@@ -624,6 +778,9 @@ int cell_read_args() {
     shift();
     sagdist.save(args());
     }
+  else if(argis("-sag_gdist_stream")) {
+    shift(); stream_file = args();
+    }
   else if(argis("-sag_gdist_load")) {
     distance_only = false;
     shift(); distance_file = args();
@@ -632,6 +789,12 @@ int cell_read_args() {
     distance_only = true;
     shift(); distance_file = args();
     }
+  else if(argis("-sag-oracle")) {
+    shift(); distance_oracle = argi();
+    }
+  else if(argis("-sag-oracle-tiles")) {
+    shift(); sagdist.max_tiles = argi();
+    }
   else if(argis("-sag-angular")) {
     shift(); angular = argi();
     }
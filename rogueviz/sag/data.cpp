@@ -202,35 +202,29 @@ void read_weighted(const char *fname) {
   init_cells();
 
   maxweight = 0;
-  fhstream f(fname, "rt");
-  if(!f.f) throw hr_exception("readsag_weighted: failed to open");
-
-  while(!feof(f.f)) {
-    string l1, l2;
-    while(true) {
-      int c = fgetc(f.f);
-      if(c == EOF) goto after;
-      else if(c == ';') break;
-      else if(rv_ignore(c)) ;
-      else l1 += c;
-      }
-    while(true) {
-      int c = fgetc(f.f);
-      if(c == EOF) goto after;
-      else if(c == ';') break;
-      else if(rv_ignore(c)) ;
-      else l2 += c;
-      }
+  graph_file f(fname, "sag-weighted", false, [] (const char*& p, const char *end, graph_chunk& out) {
+    std::string_view l1, l2;
     ld wei;
-    if(!scan(f, wei)) continue;
+    if(!read_label(p, end, ';', out, l1) || !read_label(p, end, ';', out, l2)) return false;
+    /* a record with a bad weight is skipped */
+    if(!read_number(p, end, wei)) return true;
+    out.labels.push_back(l1);
+    out.labels.push_back(l2);
+    out.values.push_back(wei);
+    return true;
+    });
+  if(!f.ok) throw hr_exception("readsag_weighted: failed to open");
+
+  auto ids = f.intern();
+  sagedges.reserve(isize(sagedges) + isize(f.values));
+  for(int k=0; k<isize(f.values); k++) {
     edgeinfo ei(sag_edge);
-    ei.i = getid(l1);
-    ei.j = getid(l2);
-    ei.weight = wei;
+    ei.i = ids[f.refs[2*k]];
+    ei.j = ids[f.refs[2*k+1]];
+    ei.weight = f.values[k];
     sagedges.push_back(ei);
     }
 
-  after:
   println(hlog, "weighted graph ", fname, " read successfully");
   after_data();
   }
@@ -241,26 +235,27 @@ void read_unweighted(const char *fname) {
   if(state & SS_DATA) return;
   init_cells();  
 
-  fhstream f(fname, "rt");
-  if(!f.f) throw hr_exception("readsag_weighted: failed to open");
-
-  scanline(f);
-  set<pair<int, int> > edges;
-  
-  int all = 0, good = 0;
-  while(!feof(f.f)) {        
-    string l1 = scan<string>(f);
-    string l2 = scan<string>(f);
-    if(l1 == "") continue;
-    if(l2 == "") continue;
+  graph_file f(fname, "sag-unweighted", true, [] (const char*& p, const char *end, graph_chunk& out) {
+    auto l1 = read_token(p, end), l2 = read_token(p, end);
+    if(l1 == "" || l2 == "") return true;
+    out.labels.push_back(l1);
+    out.labels.push_back(l2);
+    return true;
+    });
+  if(!f.ok) throw hr_exception("readsag_weighted: failed to open");
+
+  auto ids = f.intern();
+  int all = isize(f.refs) / 2, good = 0;
+  std::unordered_set<long long> edges;
+  edges.reserve(all);
+  sagedges.reserve(isize(sagedges) + all);
+  for(int k=0; k<all; k++) {
     edgeinfo ei(sag_edge);
-    ei.i = getid(l1);
-    ei.j = getid(l2);
+    ei.i = ids[f.refs[2*k]];
+    ei.j = ids[f.refs[2*k+1]];
     if(ei.i > ei.j) swap(ei.i, ei.j);
-    all++;
-    if(edges.count({ei.i, ei.j})) continue;
+    if(!edges.insert((long long) ei.i << 32 | ei.j).second) continue;
     good++;
-    edges.emplace(ei.i, ei.j);
     ei.weight = 1;
     sagedges.push_back(ei);
     }
@@ -30,17 +30,18 @@ bool opt_debug = false;
 
 bool should_good = false;
 
-double costat(int vid, int sid) {
+/** the cost of vertex vid placed at sid, in the placement given by id and node (normally sagid and sagnode) */
+double costat(int vid, int sid, const vector<int>& id, const vector<int>& node) {
   if(vid < 0) return 0;
   double cost = 0;
 
   switch(method) {
     case smLogistic: {
       auto s = sagdist[sid];
-      for(auto j: edges_yes[vid]) if(sagid[j] >= -1)
-        cost += loglik_tab_y[s[sagid[j]]];
-      for(auto j: edges_no[vid]) if(sagid[j] >= -1)
-        cost += loglik_tab_n[s[sagid[j]]];
+      for(auto j: edges_yes[vid]) if(id[j] >= -1)
+        cost += loglik_tab_y[s[id[j]]];
+      for(auto j: edges_no[vid]) if(id[j] >= -1)
+        cost += loglik_tab_n[s[id[j]]];
       return -cost;
       }
 
@@ -49,8 +50,8 @@ double costat(int vid, int sid) {
       for(int j=0; j<isize(vd.edges); j++) {
         edgeinfo *ei = vd.edges[j].second;
         int t2 = vd.edges[j].first;
-        if(sagid[t2] != -1) {
-          ld cdist = sagdist[sid][sagid[t2]];
+        if(id[t2] != -1) {
+          ld cdist = sagdist[sid][id[t2]];
           ld expect = match_a / ei->weight2 + match_b;
           ld dist = cdist - expect;
           cost += dist * dist;
@@ -64,12 +65,12 @@ double costat(int vid, int sid) {
       for(int j=0; j<isize(vd.edges); j++) {
         edgeinfo *ei = vd.edges[j].second;
         int t2 = vd.edges[j].first;
-        if(sagid[t2] != -1) cost += sagdist[sid][sagid[t2]] * ei->weight2;
+        if(id[t2] != -1) cost += sagdist[sid][id[t2]] * ei->weight2;
         }
       
       if(!hubval.empty()) {
         for(auto sid2: neighbors[sid]) {
-          int vid2 = sagnode[sid2];
+          int vid2 = node[sid2];
           if(vid2 >= 0 && (hubval[vid] & hubval[vid]) == 0)
             cost += hub_penalty;
           }
@@ -82,6 +83,10 @@ double costat(int vid, int sid) {
   throw hr_exception("unknwon SAG method");
   }
 
+double costat(int vid, int sid) {
+  return costat(vid, sid, sagid, sagnode);
+  }
+
 double cost;
 
 double best_cost = 1000000000;
@@ -106,7 +111,17 @@ void compute_loglik_tab() {
 void compute_auto_rt() {
   ld sum0 = 0, sum1 = 0, sum2 = 0;
 
-  for(auto i: sagdist) {
+  if(sagdist.oracle) {
+    /* there is no table to iterate over, so use the distances between the first cells */
+    int S = min<int>(sagdist.N, 1000);
+    for(int i=0; i<S; i++) for(int j=0; j<S; j++) {
+      ld d = sagdist[i][j];
+      sum0 ++;
+      sum1 += d;
+      sum2 += d*d;
+      }
+    }
+  else for(auto i: sagdist) {
     sum0 ++;
     sum1 += i;
     sum2 += i*i;
@@ -118,6 +133,16 @@ void compute_auto_rt() {
   if(method == smLogistic) compute_loglik_tab();
   }
 
+/** evaluate costat for iters random pairs (vertex, cell), to compare the throughput of the distance backends (-sag-oracle) */
+void bench_costat(long long iters) {
+  int DN = isize(sagid), SN = isize(sagcells);
+  double total = 0;
+  int t0 = SDL_GetTicks();
+  for(long long i=0; i<iters; i++) total += costat(hrand(DN), hrand(SN));
+  int t = max<int>(SDL_GetTicks() - t0, 1);
+  println(hlog, format("costat: %lld evaluations in %d ms, %.0f per second, oracle %d, checksum %f", iters, t, iters * 1000. / t, distance_oracle, total));
+  }
+
 void optimize_sag_loglik_logistic() {
   vector<int> indist(max_sag_dist, 0);
   
@@ -259,6 +284,9 @@ int function_read_args() {
 
   if(0) ;
 
+  else if(argis("-sag-bench-cost")) {
+    shift(); bench_costat(argll());
+    }
   else if(argis("-sagrt")) {
     shift(); sag::lgsag.R = argf();
     shift(); sag::lgsag.T = argf();
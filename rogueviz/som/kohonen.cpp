@@ -67,35 +67,55 @@ void loadsamples(const string& fname) {
   data.clear();
   samples_to_show.clear();
   clear();
-  fhstream f(fname, "rt");
-  if(!f.f) {
-    fprintf(stderr, "Could not load samples: %s\n", fname.c_str());
-    return;
-    }
-  if(!scan(f, columns)) { 
-    printf("Bad format: %s\n", fname.c_str());
-    return; 
+  /* the number of columns is needed to parse the records */
+  {
+    fhstream f(fname, "rt");
+    if(!f.f) {
+      fprintf(stderr, "Could not load samples: %s\n", fname.c_str());
+      return;
+      }
+    if(!scan(f, columns)) { 
+      printf("Bad format: %s\n", fname.c_str());
+      return; 
+      }
     }
   printf("Loading samples: %s\n", fname.c_str());
-  while(true) {
-    sample s;
+  /* each record: the values, a separator, and the name up to the end of line; '!' in front of the name means it is shown */
+  graph_file f(fname, "kohonen-samples-" + its(columns), true, [] (const char*& p, const char *end, graph_chunk& out) {
+    size_t base = out.values.size();
+    for(int i=0; i<columns; i++) {
+      ld x;
+      if(!read_number(p, end, x)) { out.values.resize(base); return false; }
+      out.values.push_back(x);
+      }
+    if(p < end) p++;
+    const char *s = p;
+    bool plain = p < end && *p != '!';
+    while(p < end && *p != 10 && *p != 13) { if(rv_ignore(*p)) plain = false; p++; }
+    std::string_view name(s, p - s);
+    if(p < end) p++;
     bool shown = false;
-    alloc(s.val);
-    if(feof(f.f)) break;
-    for(int i=0; i<columns; i++)
-      if(!scan(f, s.val[i])) { goto bigbreak; }
-    fgetc(f.f);
-    while(true) {
-      int c = fgetc(f.f);
-      if(c == -1 || c == 10 || c == 13) break;
-      if(c == '!' && s.name == "") shown = true;
-      else if(!rv_ignore(c)) s.name += c;
+    if(!plain) {
+      string t;
+      for(char c: name)
+        if(c == '!' && t == "") shown = true;
+        else if(!rv_ignore(c)) t += c;
+      name = out.own(std::move(t));
       }
+    out.labels.push_back(name);
+    out.values.push_back(shown);
+    return true;
+    });
+  int n = isize(f.refs);
+  data.reserve(n);
+  for(int k=0; k<n; k++) {
+    sample s;
+    s.val.assign(f.values.begin() + k*(columns+1), f.values.begin() + k*(columns+1) + columns);
+    s.name = f.labels[f.refs[k]];
     data.push_back(std::move(s));
-    if(shown) 
+    if(f.values[k*(columns+1) + columns])
       samples_to_show.push_back(isize(data)-1);
     }
-  bigbreak:
   samples = isize(data);
   normalize();
   colnames.resize(columns);
@@ -641,33 +661,8 @@ int krad, kqty;
 
 double ttpower = 1;
 
-void step() {
-
-  if(t == 0) return;
-  initialize_dispersion();
-  initialize_neurons_initial();
-  
-  double tt = (t-.5) / tmax;
-  tt = pow(tt, ttpower);
-
-  double sigma = maxdist * tt;
-
-  int id = hrand(samples);
-  neuron& n = winner(id);
-  whowon.resize(samples);
-  whowon[id] = &n;
-
-  /* 
-  for(neuron& n2: net) {
-    int d = celldistance(n.where, n2.where);
-    double nu = learning_factor; 
-//  nu *= exp(-t*(double)maxdist/perdist);
-//  nu *= exp(-t/t2);
-    nu *= exp(-sqr(d/sigma));
-    for(int k=0; k<columns; k++)
-      n2.net[k] += nu * (irisdata[id][k] - n2.net[k]);
-    } */
-    
+/* call f(neuron, nu) for every neuron in the neighborhood of n */
+template<class T> void for_neighborhood(neuron& n, double tt, double sigma, const T& f) {
   auto cid = get_cellcrawler_id(n.where);
   cellcrawler& s = scc[cid.first];
   s.sprawl(cellwalker(n.where, cid.second));
@@ -695,12 +690,44 @@ void step() {
     else
       nu *= *(it++);
     
+    f(n2, nu);
+    }
+  }
+
+void step() {
+
+  if(t == 0) return;
+  initialize_dispersion();
+  initialize_neurons_initial();
+  
+  double tt = (t-.5) / tmax;
+  tt = pow(tt, ttpower);
+
+  double sigma = maxdist * tt;
+
+  int id = hrand(samples);
+  neuron& n = winner(id);
+  whowon.resize(samples);
+  whowon[id] = &n;
+
+  /* 
+  for(neuron& n2: net) {
+    int d = celldistance(n.where, n2.where);
+    double nu = learning_factor; 
+//  nu *= exp(-t*(double)maxdist/perdist);
+//  nu *= exp(-t/t2);
+    nu *= exp(-sqr(d/sigma));
+    for(int k=0; k<columns; k++)
+      n2.net[k] += nu * (irisdata[id][k] - n2.net[k]);
+    } */
+    
+  for_neighborhood(n, tt, sigma, [&] (neuron *n2, double nu) {
     for(int k=0; k<columns; k++) {
       n2->net[k] += nu * (data[id].val[k] - n2->net[k]);
       /* if(isnan(n2->net[k]))
         throw hr_exception("obtained nan somehow, nu = " + lalign(0, nu)); */
       }
-    }
+    });
 
   /* for(auto& n2: net) {
     if(n2.debug > 1) throw hr_exception("sprawler error");
@@ -710,6 +737,187 @@ void step() {
   t--; if(t == 0) analyze();
   }
 
+/* The batch mode. step() above is the reference implementation; it looks for
+ * the winner in double precision and updates the network after every sample.
+ * Much of its time is spent in winner(), so the batch mode keeps a packed
+ * float copy of the neurons and samples (premultiplied by weights, rows padded
+ * to PACK floats), finds the winners of a whole batch in parallel, and then
+ * applies the averaged updates: each neuron moves by sum nu*(x-w) / max(1, sum nu),
+ * which for batch size 1 is exactly the online rule. Samples won by the same
+ * neuron share the neighborhood, so it is computed once per distinct winner.
+ */
+
+static constexpr int PACK = 8;
+
+vector<float> packed_net, packed_data;
+int packed_stride;
+
+void repack_neuron(int i) {
+  float *w = &packed_net[i * packed_stride];
+  for(int k=0; k<columns; k++) w[k] = net[i].net[k] * weights[k];
+  }
+
+/* must be called whenever the neurons, samples or weights have been changed by something else than batch_steps */
+void pack_neurons() {
+  packed_stride = (columns + PACK - 1) / PACK * PACK;
+  packed_net.assign(isize(net) * packed_stride, 0);
+  for(int i=0; i<isize(net); i++) repack_neuron(i);
+  packed_data.assign(samples * packed_stride, 0);
+  for(int s=0; s<samples; s++)
+    for(int k=0; k<columns; k++)
+      packed_data[s * packed_stride + k] = data[s].val[k] * weights[k];
+  }
+
+/* the same as winner(id), but on the packed copy; the PACK independent
+ * partial sums let the compiler vectorize the inner loop */
+int winner_packed(int id) {
+  const int N = isize(net), S = packed_stride;
+  const float *x = &packed_data[id * S];
+  float bdiff = HUGE_VALF;
+  int best = 0;
+  for(int i=0; i<N; i++) {
+    const float *w = &packed_net[i * S];
+    float part[PACK] = {};
+    for(int k=0; k<S; k+=PACK)
+      for(int j=0; j<PACK; j++) {
+        float d = w[k+j] - x[k+j];
+        part[j] += d * d;
+        }
+    float diff = 0;
+    for(int j=0; j<PACK; j++) diff += part[j];
+    if(diff < bdiff) bdiff = diff, best = i;
+    }
+  return best;
+  }
+
+/* perform count steps (or less if t reaches 0), batch samples at a time */
+void batch_steps(int count, int batch) {
+  if(t == 0) return;
+  initialize_dispersion();
+  initialize_neurons_initial();
+  pack_neurons();
+  whowon.resize(samples);
+
+  int N = isize(net);
+  vector<int> ids, wins, winners, wcount(N, 0), slot(N);
+  vector<double> wsum;
+  struct contribution { int from; double nu; };
+  vector<pair<int, contribution>> contribs;
+  vector<contribution> sorted;
+  vector<int> start;
+
+  while(count > 0 && t > 0) {
+    int B = min(batch, min(count, t));
+
+    double tt = (t-.5) / tmax;
+    tt = pow(tt, ttpower);
+    double sigma = maxdist * tt;
+
+    ids.resize(B); wins.resize(B);
+    for(int& id: ids) id = hrand(samples);
+
+    parallelize(B, [&] (int a, int b) {
+      for(int i=a; i<b; i++) wins[i] = winner_packed(ids[i]);
+      return 0;
+      });
+
+    /* samples with the same winner share the neighborhood, so only their sum and count matter */
+    winners.clear();
+    for(int i=0; i<B; i++) {
+      int w = wins[i];
+      whowon[ids[i]] = &net[w];
+      if(!wcount[w]) slot[w] = isize(winners), winners.push_back(w);
+      wcount[w]++;
+      }
+    wsum.assign(isize(winners) * columns, 0);
+    for(int i=0; i<B; i++) {
+      double *ws = &wsum[slot[wins[i]] * columns];
+      auto& x = data[ids[i]].val;
+      for(int k=0; k<columns; k++) ws[k] += x[k];
+      }
+
+    /* the crawlers are shared, so the neighborhoods are listed sequentially */
+    contribs.clear();
+    for(int w: winners)
+      for_neighborhood(net[w], tt, sigma, [&] (neuron *n2, double nu) {
+        contribs.emplace_back(neuronId(*n2), contribution{w, nu});
+        });
+
+    /* bucket the contributions by the neuron they affect */
+    start.assign(N+1, 0);
+    for(auto& c: contribs) start[c.first+1]++;
+    for(int i=0; i<N; i++) start[i+1] += start[i];
+    sorted.resize(isize(contribs));
+    {
+    vector<int> pos(start.begin(), start.end()-1);
+    for(auto& c: contribs) sorted[pos[c.first]++] = c.second;
+    }
+
+    parallelize(N, [&] (int a, int b) {
+      kohvec delta;
+      alloc(delta);
+      for(int i=a; i<b; i++) {
+        if(start[i] == start[i+1]) continue;
+        for(int k=0; k<columns; k++) delta[k] = 0;
+        double total = 0;
+        for(int j=start[i]; j<start[i+1]; j++) {
+          auto& c = sorted[j];
+          const double *ws = &wsum[slot[c.from] * columns];
+          for(int k=0; k<columns; k++) delta[k] += c.nu * ws[k];
+          total += c.nu * wcount[c.from];
+          }
+        auto& w = net[i].net;
+        double div = max(total, 1.);
+        for(int k=0; k<columns; k++) w[k] += (delta[k] - total * w[k]) / div;
+        repack_neuron(i);
+        }
+      return 0;
+      });
+
+    for(int w: winners) wcount[w] = 0;
+    t -= B; count -= B;
+    if(t == 0) analyze();
+    }
+  }
+
+/* compare the online and batch modes on n samples each, starting from the current network */
+void bench_batch(int n, int batch) {
+  initialize_dispersion();
+  initialize_neurons_initial();
+  vector<kohvec> saved;
+  for(auto& ne: net) saved.push_back(ne.net);
+  int saved_t = t;
+  auto restore = [&] { for(int i=0; i<isize(net); i++) net[i].net = saved[i]; t = saved_t; };
+  if(t == 0) saved_t = t = tmax;
+  n = min(n, t);
+
+  int t0 = SDL_GetTicks();
+  for(int i=0; i<n; i++) step();
+  int t1 = max<int>(SDL_GetTicks() - t0, 1);
+  restore();
+
+  t0 = SDL_GetTicks();
+  batch_steps(n, batch);
+  int t2 = max<int>(SDL_GetTicks() - t0, 1);
+  restore();
+
+  pack_neurons();
+  int tests = min(samples, 1000), agree = 0;
+  vector<int> bmu_double(tests), bmu_float(tests);
+  t0 = SDL_GetTicks();
+  for(int s=0; s<tests; s++) bmu_double[s] = neuronId(winner(s));
+  int t3 = max<int>(SDL_GetTicks() - t0, 1);
+  t0 = SDL_GetTicks();
+  for(int s=0; s<tests; s++) bmu_float[s] = winner_packed(s);
+  int t4 = max<int>(SDL_GetTicks() - t0, 1);
+  for(int s=0; s<tests; s++) if(bmu_double[s] == bmu_float[s]) agree++;
+
+  println(hlog, format("SOM: %d neurons, %d columns, %d threads", isize(net), columns, threads));
+  println(hlog, format("online: %d samples in %d ms, %.0f samples/s", n, t1, n * 1000. / t1));
+  println(hlog, format("batch %d: %d samples in %d ms, %.0f samples/s", batch, n, t2, n * 1000. / t2));
+  println(hlog, format("winner search: double %.0f/s, packed %.0f/s, agreement %d/%d", tests * 1000. / t3, tests * 1000. / t4, agree, tests));
+  }
+
 int initdiv = 1;
 
 flagtype state = 0;
@@ -1713,6 +1921,18 @@ int readArgs() {
       kohonen::step();
       }
     }
+  else if(argis("-somrunto-batch")) {
+    shift(); int i = argi();
+    shift(); int batch = argi();
+    while(t > i) {
+      progress("Steps left: " + its(t));
+      batch_steps(min(t - i, 1024), batch);
+      }
+    }
+  else if(argis("-som-bench-batch")) {
+    shift(); int n = argi();
+    shift(); bench_batch(n, argi());
+    }
   else if(argis("-somstop")) {
     t = 0;
     }
@@ -71,6 +71,7 @@ void clear();
 void create_neurons();
 void analyze();
 void step();
+void batch_steps(int count, int batch);
 void initialize_rv();
 void set_neuron_initial();
 bool finished();
@@ -27,6 +27,37 @@ EX int SDL_GetTicks() {
 #endif
 #endif
 
+/** the number of threads used by the parallelized computations in the engine, such as irregular map generation */
+#if CAP_THREAD
+EX int engine_threads = max<int>(std::thread::hardware_concurrency(), 1);
+#else
+EX int engine_threads = 1;
+#endif
+
+#if HDR
+/** split [0,N) into engine_threads ranges and call action(a,b) on each of them in a separate thread; returns the sum of the results */
+template<class T> auto run_parallel(long long N, T action) -> decltype(action(0,0)) {
+  #if CAP_THREAD
+  int threads = engine_threads;
+  if(N < threads) threads = max<int>(N, 1);
+  if(threads == 1) return action(0, N);
+  std::vector<std::thread> v;
+  typedef decltype(action(0,0)) Res;
+  std::vector<Res> results(threads);
+  for(int k=0; k<threads; k++)
+    v.emplace_back([&,k] () {
+      results[k] = action(N*k/threads, N*(k+1)/threads);
+      });
+  for(std::thread& t:v) t.join();
+  Res res = 0;
+  for(Res r: results) res += r;
+  return res;
+  #else
+  return action(0, N);
+  #endif
+  }
+#endif
+
 EX long double sqr(long double x) { return x*x; }
 
 EX ld round_nearest(ld x) { if(x > 0) return int(x+.5); else return -int(.5-x); }